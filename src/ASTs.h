@@ -113,6 +113,8 @@ constexpr AST_info AST_descriptor[] =
 	a("compile", T::function_pointer, compile_without_type_check), //compiles an AST, returning a dynamic AST. for now, we don't return an error code. can also take nothing, to type bootstrap.
 	a("overfunc", T::integer, T::function_pointer, T::function_pointer), //overwrites the first function with the second. return 1 on success. checks both function pointers for nonzero.
 	{"run_function", T::dynamic_object, T::function_pointer},
+	{"run_function_with", T::dynamic_object, T::function_pointer, compile_without_type_check}, //runs the function, passing the second field as its parameters. returns 0 if they don't match the function's parameter type.
+	{"parameter", special_return, T::type}, //a parameter of the function being compiled. the type must be a constant, like from typeof. parameters are ordered by when they're first compiled. see doc/parameters
 	//{"dynamic_conc", T::dynamic_pointer, T::dynamic_pointer, compile_without_type_check}, //concatenate the interiors of two dynamic objects
 	a("goto", T::null).add_pointer_fields(1), //first field is label. for success and failure, user must test finiteness manually.
 	a("label", T::null).add_pointer_fields(1), //the field is like a brace. anything inside the label can goto() out of the label. the purpose is to enforce that no extra stack elements are created.
@@ -139,7 +141,7 @@ constexpr AST_info AST_descriptor[] =
 	//{"return", T::special_return, T::compile_without_type_check}, have to check that the type matches the actual return type. call all dtors. we can take T::does_not_return, but that just disables the return.
 	//{"snapshot", T::dynamic_pointer, T::dynamic object}, //makes a deep copy. ought to return size as well, since size is a way to cheat, by growing larger.
 	//{"copy_target", T::special_return, T::compile_without_type_check}, //does a shallow copy. good for dynamic pointers, vectors.
-	//{"optimize", T::AST_pointer, T::AST_pointer}, //optimizes an AST chain into a better AST chain that produces the same code.
+	{"optimize", T::AST_pointer, T::AST_pointer}, //optimizes an AST chain into a better AST chain that produces the same code. returns the same AST if it doesn't validate. see optimizer.h
 	//{"send_message", T::integer, T::integer, T::dynamic_object}, //returns 1 on success. integer is user-ID, dynamic object is what is to be sent.
 	{"never reached", special_return}, //marks the end of the currently-implemented ASTs. beyond this is rubbish.
 	/*
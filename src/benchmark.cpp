@@ -0,0 +1,38 @@
+#include <algorithm>
+#include <numeric>
+#include "benchmark.h"
+#include "globalinfo.h"
+
+void benchmark_recorder::record(const std::string& name, double nanoseconds_per_operation, uint64_t batch)
+{
+	auto found = std::find_if(benchmarks.begin(), benchmarks.end(), [&](const benchmark_samples& b) { return b.name == name; });
+	if (found == benchmarks.end())
+	{
+		benchmarks.push_back({name, batch, {}});
+		found = benchmarks.end() - 1;
+	}
+	check(found->batch == batch, "benchmark " + name + " changed its batch size");
+	found->nanoseconds.push_back(nanoseconds_per_operation);
+}
+
+//nearest rank. the samples must be sorted.
+static double percentile(const std::vector<double>& sorted, uint64_t p)
+{
+	uint64_t rank = (p * sorted.size() + 99) / 100;
+	return sorted[rank ? rank - 1 : 0];
+}
+
+void benchmark_recorder::write_json(std::ostream& output, uint64_t seed) const
+{
+	output << "{\"seed\":" << seed << ",\"optimization_level\":" << OPTIMIZATION_LEVEL << ",\"benchmarks\":[";
+	for (uint64_t x = 0; x < benchmarks.size(); ++x)
+	{
+		std::vector<double> sorted = benchmarks[x].nanoseconds;
+		std::sort(sorted.begin(), sorted.end());
+		double mean = std::accumulate(sorted.begin(), sorted.end(), 0.0) / sorted.size();
+		output << (x ? ",\n" : "\n") << "{\"name\":\"" << benchmarks[x].name << "\",\"samples\":" << sorted.size() << ",\"batch\":" << benchmarks[x].batch
+			<< ",\"min_ns\":" << sorted.front() << ",\"p50_ns\":" << percentile(sorted, 50) << ",\"p90_ns\":" << percentile(sorted, 90) << ",\"p99_ns\":" << percentile(sorted, 99)
+			<< ",\"max_ns\":" << sorted.back() << ",\"mean_ns\":" << mean << ",\"operations_per_second\":" << (mean > 0 ? 1e9 / mean : 0) << '}';
+	}
+	output << "\n]}\n";
+}
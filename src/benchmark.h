@@ -0,0 +1,39 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/* results for the benchmark suite, which is in testdriver.cpp. "benchsuite results.json" runs it, and writes the results to the named file.
+the suite seeds mersenne with a fixed seed (the "seed" flag, or 1), so that two runs do the same work and their numbers can be compared.
+each sample is nanoseconds per operation. cheap operations are timed in batches, so that reading the clock doesn't dominate.
+the JSON lists each benchmark's samples, batch size, min, p50, p90, p99, max, mean, and operations per second.
+*/
+inline uint64_t benchmark_now() { return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count(); }
+
+class benchmark_recorder
+{
+	struct benchmark_samples
+	{
+		std::string name;
+		uint64_t batch;
+		std::vector<double> nanoseconds;
+	};
+	std::vector<benchmark_samples> benchmarks; //in the order they were first recorded
+public:
+	void record(const std::string& name, double nanoseconds_per_operation, uint64_t batch = 1);
+
+	//times one sample of batch operations. to run setup between samples without timing it, call this once per sample.
+	template<typename F> void measure(const std::string& name, uint64_t samples, uint64_t batch, F operation)
+	{
+		for (uint64_t s = 0; s < samples; ++s)
+		{
+			uint64_t start = benchmark_now();
+			for (uint64_t x = 0; x < batch; ++x) operation();
+			record(name, (double)(benchmark_now() - start) / batch, batch);
+		}
+	}
+
+	void write_json(std::ostream& output, uint64_t seed) const;
+};
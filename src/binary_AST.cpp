@@ -0,0 +1,258 @@
+#include <cstring>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/SmallPtrSet.h>
+#include <llvm/ADT/SmallVector.h>
+#include "binary_AST.h"
+#include "trace.h"
+
+//an imv of these types is only numbers, so it means the same thing when it's loaded.
+static bool is_plain_data(Tptr t)
+{
+	if (t == 0) return false;
+	if (t.ver() == Typen("integer")) return true;
+	if (t.ver() != Typen("con_vec")) return false;
+	for (Tptr& field : Type_pointer_range(t))
+		if (!is_plain_data(field)) return false;
+	return true;
+}
+
+namespace
+{
+class binary_AST_writer
+{
+	const std::unordered_map<uAST*, string>& external_names;
+	llvm::DenseMap<uAST*, uint64_t> index;
+	std::vector<uAST*> order;
+
+	//children first. an AST is numbered once all its children are, except for the ones still on the stack, which make a cycle.
+	//it's a loop instead of recursion, because generated programs can be deep.
+	void number(uAST* root)
+	{
+		llvm::SmallPtrSet<uAST*, 32> entered;
+		entered.insert(root);
+		std::vector<std::pair<uAST*, uint64_t>> stack{{root, 0}}; //the AST, and which child is next.
+		while (!stack.empty())
+		{
+			uAST* t = stack.back().first;
+			AST_range children(t);
+			uint64_t next = stack.back().second;
+			if (children.begin() + next != children.end())
+			{
+				++stack.back().second;
+				uAST* child = children.begin()[next];
+				if (child && entered.insert(child).second) stack.push_back({child, 0});
+			}
+			else
+			{
+				index.insert({t, order.size()});
+				order.push_back(t);
+				stack.pop_back();
+			}
+		}
+	}
+
+	uint64_t reference(uAST* t) { return t ? index.lookup(t) : ~0ull; }
+
+	void write_type(Tptr t)
+	{
+		if (t == 0)
+		{
+			words.push_back(~0ull);
+			return;
+		}
+		words.push_back(t.ver());
+		if (t.ver() == Typen("con_vec")) words.push_back(t.field(0));
+		for (Tptr& field : Type_pointer_range(t)) write_type(field);
+	}
+
+	void write_imv(uAST* t)
+	{
+		dynobj* object = (dynobj*)t->fields[0];
+		auto name = external_names.find(t->fields[0]);
+		if (object == nullptr) words.push_back(imv_null);
+		else if (name != external_names.end())
+		{
+			words.push_back(imv_external);
+			words.push_back(name->second.size());
+			uint64_t start = words.size();
+			words.resize(start + (name->second.size() + 7) / 8, 0);
+			memcpy(&words[start], name->second.data(), name->second.size());
+		}
+		else
+		{
+			if (!is_plain_data(object->type)) error("can't write an imv that holds pointers, unless it has an external name");
+			words.push_back(imv_inline);
+			write_type(object->type);
+			for (uint64_t x = 0; x < get_size(object->type); ++x) words.push_back((*object)[x]);
+		}
+	}
+
+public:
+	std::vector<uint64_t> words;
+	binary_AST_writer(uAST* root, const std::unordered_map<uAST*, string>& e) : external_names(e)
+	{
+		if (root) number(root);
+		words = {binary_AST_magic, binary_AST_version, order.size(), reference(root)};
+		for (uAST* t : order)
+		{
+			words.push_back(t->tag);
+			if (t->tag == ASTn("imv")) write_imv(t);
+			else
+			{
+				if (t->tag == ASTn("basicblock")) words.push_back(((svector*)t->fields[0])->size);
+				for (uAST* field : AST_range(t)) words.push_back(reference(field));
+			}
+		}
+	}
+};
+
+class binary_AST_reader
+{
+	const uint64_t* next;
+	const uint64_t* end;
+	const std::unordered_map<string, uAST*>& externals;
+	std::vector<uAST*> nodes;
+	std::vector<std::pair<uAST**, uint64_t>> forward_references; //a field, and the node index it's waiting for.
+
+	uint64_t word()
+	{
+		if (next == end) error("binary AST ends in the middle of a record");
+		return *next++;
+	}
+
+	//the AST in this field might not exist yet. if it doesn't, the field is patched at the end.
+	uAST* reference(uint64_t index, uint64_t current)
+	{
+		if (index == ~0ull) return nullptr;
+		if (index >= nodes.size()) error("binary AST refers to node " + std::to_string(index) + ", which doesn't exist");
+		return index < current ? nodes[index] : nullptr;
+	}
+	void note_forward(uAST** field, uint64_t index, uint64_t current)
+	{
+		if (index != ~0ull && index >= current) forward_references.push_back({field, index});
+	}
+
+	Tptr read_type()
+	{
+		uint64_t tag = word();
+		if (tag == ~0ull) return 0;
+		if (tag >= Typen("never reached")) error("binary AST has type tag " + std::to_string(tag));
+		uint64_t number_of_fields = tag == Typen("con_vec") ? word() : Type_descriptor[tag].pointer_fields;
+		if (tag == Typen("con_vec") && number_of_fields < 2) error("binary AST has a con_vec with fewer than 2 elements");
+		llvm::SmallVector<Tptr, 4> fields;
+		for (uint64_t x = 0; x < number_of_fields; ++x) fields.push_back(read_type());
+		return new_unique_type(tag, fields);
+	}
+
+	uAST* read_imv()
+	{
+		uint64_t kind = word();
+		if (kind == imv_null) return new_AST(ASTn("imv"), {nullptr});
+		if (kind == imv_inline)
+		{
+			Tptr type = read_type();
+			if (!is_plain_data(type)) error("binary AST has an inline imv that isn't integers");
+			dynobj* object = new_dynamic_obj(type);
+			for (uint64_t x = 0; x < get_size(type); ++x) (*object)[x] = word();
+			return new_AST(ASTn("imv"), {(uAST*)object});
+		}
+		if (kind == imv_external)
+		{
+			uint64_t length = word();
+			uint64_t length_in_words = (length + 7) / 8;
+			if (length_in_words > (uint64_t)(end - next)) error("binary AST ends in the middle of a name");
+			string name((const char*)next, length);
+			next += length_in_words;
+			auto found = externals.find(name);
+			if (found == externals.end()) error("binary AST names an object that wasn't given: " + name);
+			return new_AST(ASTn("imv"), {found->second});
+		}
+		error("binary AST has imv kind " + std::to_string(kind));
+	}
+
+public:
+	uAST* root = nullptr;
+	binary_AST_reader(llvm::ArrayRef<uint64_t> words, const std::unordered_map<string, uAST*>& e) : next(words.begin()), end(words.end()), externals(e)
+	{
+		if (word() != binary_AST_magic) error("not a binary AST");
+		uint64_t version = word();
+		if (version != binary_AST_version) error("binary AST is version " + std::to_string(version) + ", but this reads version " + std::to_string(binary_AST_version));
+		uint64_t number_of_nodes = word();
+		if (number_of_nodes > (uint64_t)(end - next)) error("binary AST claims more nodes than it has words");
+		nodes.resize(number_of_nodes);
+		uint64_t root_index = word();
+
+		for (uint64_t current = 0; current < number_of_nodes; ++current)
+		{
+			uint64_t tag = word();
+			if (tag >= ASTn("never reached")) error("binary AST has AST tag " + std::to_string(tag));
+			if (tag == ASTn("imv"))
+			{
+				nodes[current] = read_imv();
+				continue;
+			}
+			uint64_t number_of_fields = tag == ASTn("basicblock") ? word() : AST_descriptor[tag].pointer_fields;
+			if (number_of_fields > (uint64_t)(end - next)) error("binary AST ends in the middle of a record");
+			llvm::SmallVector<uAST*, 8> fields;
+			for (uint64_t x = 0; x < number_of_fields; ++x) fields.push_back(reference(next[x], current));
+			uAST* t = nodes[current] = new_AST(tag, fields);
+			uAST** field = AST_range(t).begin();
+			for (uint64_t x = 0; x < number_of_fields; ++x) note_forward(field + x, word(), current);
+		}
+		if (next != end) error("binary AST has words after the last record");
+
+		for (auto& k : forward_references) *k.first = nodes[k.second];
+		if (root_index != ~0ull && root_index >= number_of_nodes) error("binary AST's root doesn't exist");
+		root = root_index == ~0ull ? nullptr : nodes[root_index];
+	}
+};
+}
+
+std::vector<uint64_t> encode_binary_AST(uAST* root, const std::unordered_map<uAST*, string>& external_names)
+{
+	return binary_AST_writer(root, external_names).words;
+}
+
+uAST* decode_binary_AST(llvm::ArrayRef<uint64_t> words, const std::unordered_map<string, uAST*>& externals)
+{
+	return binary_AST_reader(words, externals).root;
+}
+
+void write_binary_AST(const string& filename, uAST* root, const std::unordered_map<uAST*, string>& external_names)
+{
+	std::vector<uint64_t> words = encode_binary_AST(root, external_names);
+	std::ofstream output(filename, std::ofstream::binary | std::ofstream::trunc);
+	output.write((const char*)words.data(), words.size() * sizeof(uint64_t));
+	if (!output.good()) error("couldn't write binary AST to " + filename);
+}
+
+uAST* load_binary_AST(const string& filename, const std::unordered_map<string, uAST*>& externals)
+{
+	trace_span span("load_binary_AST");
+	int descriptor = open(filename.c_str(), O_RDONLY);
+	if (descriptor == -1) error("couldn't open binary AST " + filename);
+	struct stat file_info;
+	if (fstat(descriptor, &file_info) == -1) error("couldn't stat binary AST " + filename);
+	uint64_t size = file_info.st_size;
+	if (size == 0 || size % sizeof(uint64_t)) error("binary AST " + filename + " isn't a whole number of words");
+	void* memory = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+	close(descriptor);
+	if (memory == MAP_FAILED) error("couldn't mmap binary AST " + filename);
+	madvise(memory, size, MADV_SEQUENTIAL);
+	uAST* root = decode_binary_AST(llvm::ArrayRef<uint64_t>((const uint64_t*)memory, size / sizeof(uint64_t)), externals);
+	munmap(memory, size);
+	return root;
+}
+
+bool is_binary_AST_file(const string& filename)
+{
+	std::ifstream input(filename, std::ifstream::binary);
+	uint64_t magic = 0;
+	input.read((char*)&magic, sizeof(magic));
+	return input.good() && magic == binary_AST_magic;
+}
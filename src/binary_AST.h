@@ -0,0 +1,29 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <llvm/ADT/ArrayRef.h>
+#include "ASTs.h"
+
+/* a binary format for AST programs, so that big ones load fast. the text format (source_reader) goes character by character, and looks every name up in a map. this is an array of words, which the loader mmaps and reads front to back.
+every entry is a uint64_t, in the machine's byte order:
+	header: binary_AST_magic, binary_AST_version, the number of nodes, and the root's node index.
+	then one record per node, in node index order:
+		most ASTs: the tag, then the node index of each pointer field.
+		basicblock: the tag, the number of elements, then the node index of each element.
+		imv: the tag, then a binary_imv_kind. imv_null has nothing after it. imv_inline has a type descriptor, then the object's words. imv_external has the name's length in bytes, then the name, padded to whole words.
+	a type descriptor is the type's tag, then its fields' descriptors. a con_vec has its number of elements after the tag. the null type is ~0ull.
+	the node index ~0ull is nullptr.
+nodes are written children first, so the only indices that point forward close a cycle, like a goto inside the label it names. the loader patches those after the last record.
+only imvs of integers are written inline. other imvs hold pointers, which mean nothing in another process, so the writer needs a name for them, and the loader looks the name up. these are the same objects that the "file" mode puts in source_reader's ASTmap.
+*/
+constexpr uint64_t binary_AST_magic = 0x0054534131315343ull; //"CS11AST", then a zero byte.
+constexpr uint64_t binary_AST_version = 1;
+enum binary_imv_kind : uint64_t { imv_null, imv_inline, imv_external };
+
+std::vector<uint64_t> encode_binary_AST(uAST* root, const std::unordered_map<uAST*, string>& external_names = {});
+uAST* decode_binary_AST(llvm::ArrayRef<uint64_t> words, const std::unordered_map<string, uAST*>& externals = {});
+
+void write_binary_AST(const string& filename, uAST* root, const std::unordered_map<uAST*, string>& external_names = {});
+uAST* load_binary_AST(const string& filename, const std::unordered_map<string, uAST*>& externals = {}); //mmaps the file.
+bool is_binary_AST_file(const string& filename); //checks the magic word, so that "file" can take either format.
@@ -1,4 +1,75 @@
+#include <algorithm>
+#include <cstring>
+#include <vector>
 #include "comms.h"
 uint64_t mmap_size;
 std::atomic<uint64_t>* receive_mem;
-std::atomic<uint64_t>* send_mem;
\ No newline at end of file
+std::atomic<uint64_t>* send_mem;
+
+bool FARM_WORKER = false;
+static uint64_t farm_worker_number;
+static multiple_sender_queue farm_receiver;
+static multiple_sender_queue farm_admin;
+static bool farm_admin_known = false;
+static std::vector<multiple_sender_queue> farm_peers;
+
+void join_farm(uint64_t worker_number, uint64_t queue_ID, uint64_t size)
+{
+	FARM_WORKER = true;
+	farm_worker_number = worker_number;
+	mmap_size = size;
+	farm_receiver.memory_location = (std::atomic<uint64_t>*)open_memory(queue_ID);
+}
+
+bool receive_farm_AST(std::string& AST_text)
+{
+	while (farm_receiver.should_I_load())
+	{
+		switch (farm_receiver.get_next_value())
+		{
+		case file_ID_of_admin:
+			farm_admin.memory_location = (std::atomic<uint64_t>*)open_memory(farm_receiver.get_next_value());
+			farm_admin_known = true;
+			break;
+		case file_ID_of_user:
+			farm_receiver.get_next_value(); //the worker number, which doesn't matter here.
+			farm_peers.push_back(open_memory(farm_receiver.get_next_value()));
+			break;
+		case aliveness_check:
+			if (farm_admin_known) farm_admin.write_values({existence_ping, farm_worker_number});
+			break;
+		case shared_AST:
+			{
+				uint64_t bytes = farm_receiver.get_next_value();
+				AST_text.resize(bytes);
+				for (uint64_t x = 0; x < bytes; x += sizeof(uint64_t))
+				{
+					uint64_t word = farm_receiver.get_next_value();
+					memcpy(&AST_text[x], &word, std::min<uint64_t>(sizeof(uint64_t), bytes - x));
+				}
+				return true;
+			}
+		default:
+			error("unknown event enum");
+		}
+	}
+	return false;
+}
+
+void share_farm_AST(const std::string& AST_text)
+{
+	std::vector<uint64_t> message{shared_AST, AST_text.size()};
+	message.resize(2 + (AST_text.size() + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+	memcpy(&message[2], AST_text.data(), AST_text.size());
+	if (message.size() > farm_receiver.capacity() / 4) return; //a huge AST would crowd out everything else.
+	for (auto& peer : farm_peers)
+		peer.try_write_values(message); //a full queue means the peer is behind, and it can do without this AST.
+}
+
+void report_farm_stats(uint64_t iterations, llvm::ArrayRef<uint64_t> hitcount)
+{
+	if (!farm_admin_known) return;
+	std::vector<uint64_t> message{farm_stats, farm_worker_number, iterations, hitcount.size()};
+	message.insert(message.end(), hitcount.begin(), hitcount.end());
+	farm_admin.write_values(message); //the admin is always reading, so this won't wait long.
+}
@@ -1,3 +1,4 @@
+#pragma once
 #include "globalinfo.h"
 #include <atomic>
 #include "generic_ipc.h"
@@ -5,4 +6,16 @@
 //sender position, then user read position, then memory start.
 //each user has one receiver and one sender.
 extern std::atomic<uint64_t>* receive_mem;
-extern std::atomic<uint64_t>* send_mem;
\ No newline at end of file
+extern std::atomic<uint64_t>* send_mem;
+
+/* farm mode. "admin farm N", in user_admin/mmap.cpp, starts N fuzzing workers. each runs "toy farm <worker number> <queue ID> <mmap size>".
+before starting a worker, the admin writes into its queue: the admin's queue ID, then the other workers' queue IDs.
+when a worker's fuzzer compiles an AST, it sends the AST to the other workers in the console format, and they add it to their corpus.
+each worker reports its iterations and hitcount to the admin, which adds them up.
+shared ASTs are dropped when a queue is full, instead of waiting. otherwise, two workers sending to each other could deadlock.
+*/
+extern bool FARM_WORKER;
+void join_farm(uint64_t worker_number, uint64_t queue_ID, uint64_t size);
+bool receive_farm_AST(std::string& AST_text); //handles the queue's events until it finds an AST. false if the queue ran out first.
+void share_farm_AST(const std::string& AST_text);
+void report_farm_stats(uint64_t iterations, llvm::ArrayRef<uint64_t> hitcount); //totals, not the change since the last report.
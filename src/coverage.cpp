@@ -0,0 +1,19 @@
+#include <array>
+#include "coverage.h"
+#include "utility.h"
+
+uint64_t features_seen = 0;
+static std::array<bool, coverage_map_size> coverage_map;
+
+void set_feature(feature_kind kind, uint64_t a, uint64_t b, uint64_t c)
+{
+	uint64_t h = fnv_offset_basis;
+	for (uint64_t word : {(uint64_t)kind, a, b, c})
+		h = hash_combine(h, word);
+	bool& bit = coverage_map[(h ^ (h >> 32)) % coverage_map_size];
+	if (!bit)
+	{
+		bit = true;
+		++features_seen;
+	}
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <cstdint>
+#include "globalinfo.h"
+#include "types.h"
+
+/* feature coverage, for guiding the fuzzer. see fuzztester()
+a feature is something the compiler or runtime did:
+	an AST of some tag that validated with some type.
+	an error code at some tag and field, with the type that the field had.
+	an outcome in a runtime helper, like running out of finiteness.
+compile features are recorded by the validator. it mirrors generate_IR() case by case, runs first in every compile, and generate_IR() never sees an AST that fails it.
+features are hashed into a bitmap, like AFL's edge map. the fuzzer favors the tags and corpus entries that set bits nobody had set before.
+they're only recorded in "guided" mode. otherwise, a feature costs a branch.
+*/
+enum class feature_kind : uint64_t { compiled, error, runtime };
+enum class runtime_feature : uint64_t { run_without_function, run_without_arguments, run_out_of_finiteness, run_function, inline_cache_miss };
+constexpr uint64_t coverage_map_size = 1 << 16;
+
+extern uint64_t features_seen; //how many bits of the map are set. the fuzzer diffs this across an iteration.
+void set_feature(feature_kind kind, uint64_t a, uint64_t b, uint64_t c);
+inline void record_feature(feature_kind kind, uint64_t a, uint64_t b = 0, uint64_t c = 0) { if (FUZZ_GUIDED) set_feature(kind, a, b, c); }
+
+//the type's tag and size, not the whole type, so that every distinct concatenation doesn't flood the map.
+inline uint64_t feature_of_type(Tptr t) { return t == 0 ? 0 : t.ver() << 32 | get_size(t); }
@@ -15,6 +15,10 @@ generate_IR() is the main AST conversion tool. it turns ASTs into llvm::Values,
 #include <llvm/Support/TargetSelect.h>
 #include <llvm/IR/LegacyPassManager.h>
 #include <llvm/Transforms/Scalar.h>
+#include <llvm/Transforms/Vectorize.h>
+#include <llvm/IR/IntrinsicInst.h>
+#include <llvm/Analysis/TargetTransformInfo.h>
+#include <llvm/Target/TargetMachine.h>
 #include <llvm/Analysis/Passes.h>
 #include "llvm/ExecutionEngine/Orc/ObjectLinkingLayer.h"
 #include "llvm/ExecutionEngine/ExecutionEngine.h"
@@ -26,21 +30,55 @@ generate_IR() is the main AST conversion tool. it turns ASTs into llvm::Values,
 #include "orc.h"
 #include "vector.h"
 #include "helperfunctions.h"
+#include "validator.h"
+#include "optimizer.h"
+#include "trace.h"
 
 
 
 
-bool OPTIMIZE = false;
+uint64_t OPTIMIZATION_LEVEL = 0;
+uint64_t CODEGEN_OPT_LEVEL = ~0ull;
+uint64_t HOT_THRESHOLD = 0;
 bool VERBOSE_DEBUG = false;
 bool VERBOSE_GENERATE = false;
 bool DONT_ADD_MODULE_TO_ORC = false;
 bool DELETE_MODULE_IMMEDIATELY = false;
+bool LAZY_COMPILE = false;
+bool VALIDATOR_CROSSCHECK = false;
+bool AST_OPTIMIZE = false;
+bool INLINE_CACHE_STATS = false;
+bool PROFILE_ASTS = false;
+bool FUZZ_GUIDED = false;
+bool PERF_MAP = false;
 
 llvm::raw_ostream* llvm_console = &llvm::outs();
 KaleidoscopeJIT* c;
 llvm::LLVMContext* context;
 llvm::IRBuilder<>* IRB;
 uint64_t finiteness;
+budget_model BUDGET_MODEL = budget_model::calls;
+uint64_t TIME_LIMIT_MICROSECONDS = 1000;
+std::chrono::steady_clock::time_point finiteness_deadline;
+
+void start_finiteness_budget()
+{
+	switch (BUDGET_MODEL)
+	{
+	case budget_model::calls: finiteness = FINITENESS_LIMIT; return;
+	case budget_model::work: finiteness = WORK_LIMIT; return;
+	case budget_model::time:
+		finiteness = TIME_SLICE;
+		finiteness_deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(TIME_LIMIT_MICROSECONDS);
+		return;
+	}
+}
+
+uint64_t refill_finiteness()
+{
+	if (BUDGET_MODEL == budget_model::time && std::chrono::steady_clock::now() < finiteness_deadline) finiteness = TIME_SLICE;
+	return finiteness;
+}
 llvm::TargetMachine* TM;
 
 #include <random>
@@ -51,11 +89,6 @@ std::mt19937_64 mersenne(seeder() + ((uint64_t)seeder() << 32));
 //return value is the error code, which is 0 if successful
 uint64_t compiler_object::compile_AST(uAST* target)
 {
-	llvm::IRBuilder<> new_builder(*new_context);
-	std::unique_ptr<llvm::Module> M(new llvm::Module(GenerateUniqueName("jit_module_"), *new_context)); //should be unique ptr because ownership will be transferred
-
-	builder_context_stack b(&new_builder, new_context.get());
-
 	if (VERBOSE_DEBUG)
 	{
 		print("starting compilation "); //in case it crashes here because target is not valid
@@ -63,31 +96,90 @@ uint64_t compiler_object::compile_AST(uAST* target)
 		print('\n');
 	}
 	if (target == nullptr) return IRgen_status::null_AST;
+
+	//malformed ASTs are rejected here, before we pay for a context, a Module, or any IR.
+	//in crosscheck mode, we go on to generate_IR() anyway, to check that the two agree.
+	AST_validator validator;
+	AST_type_record validated_types;
+	bool optimize_AST_first = AST_OPTIMIZE || optimization_level >= 1;
+	if (optimize_AST_first) validator.types = &validated_types;
+	abstract_info validation = validator.validate(target);
+	if (validation.error_code && !VALIDATOR_CROSSCHECK)
+	{
+		error_location = validator.error_location;
+		error_field = validator.error_field;
+		return validation.error_code;
+	}
+	//the optimizer only sees valid ASTs, so errors are always reported against the user's AST.
+	//compile_specifying_location() keeps the user's AST in the function, not this one.
+	uAST* user_AST = target; //the perf map names the function after this, the same as function::materialize() does.
+	if (optimize_AST_first && !validation.error_code) target = optimize_validated_AST(target, validated_types);
+
+	if (!module) module = std::make_shared<jit_module>();
+	llvm::IRBuilder<> new_builder(*module->context);
+	llvm::Module* M = module->pending.get(); //ownership is transferred when the module is added to Orc
+	check(M != nullptr, "compiling into a module that has already been added");
+
+	builder_context_stack b(&new_builder, module->context.get());
+
 	using namespace llvm;
 	FunctionType *dummy_type(FunctionType::get(llvm_void(), false));
 
-	Function *dummy_func(Function::Create(dummy_type, Function::ExternalLinkage, "dummy_func", M.get())); //we have to insert the function in the Module so that it doesn't leak when generate_IR fails. things like instructions, basic blocks, and functions are not part of a context.
+	Function *dummy_func(Function::Create(dummy_type, Function::ExternalLinkage, "dummy_func", M)); //we have to insert the function in the Module so that it doesn't leak when generate_IR fails. things like instructions, basic blocks, and functions are not part of a context.
 
 	BasicBlock *BB(BasicBlock::Create(*context, "entry", dummy_func));
 	new_builder.SetInsertPoint(BB);
 
-	auto return_object = generate_IR(target);
-	if (return_object.error_code) return return_object.error_code;
+	Return_Info return_object;
+	{
+		trace_span span("generate_IR");
+		return_object = generate_IR(target);
+	}
+	if (VALIDATOR_CROSSCHECK)
+	{
+		check(validation.error_code == return_object.error_code, "validator and generate_IR disagree on the error code");
+		if (return_object.error_code)
+		{
+			check(validator.error_location == error_location, "validator and generate_IR disagree on the error location");
+			check(validator.error_field == error_field, "validator and generate_IR disagree on the error field");
+		}
+		else check(type_check(RVO, validation.type, return_object.type) == type_check_result::perfect_fit
+			&& type_check(RVO, return_object.type, validation.type) == type_check_result::perfect_fit, "validator and generate_IR disagree on the return type");
+	}
+	if (return_object.error_code)
+	{
+		dummy_func->eraseFromParent(); //the module might be shared with other functions, so it can't keep the broken code.
+		return return_object.error_code;
+	}
 
 	return_type = return_object.type;
+	llvm::SmallVector<Tptr, 4> parameter_types;
+	for (auto& parameter : parameters) parameter_types.push_back(parameter.second);
+	parameter_type = concatenate_types(parameter_types);
 	//check(return_type == uniquefy_premade_type(return_type, false), "compilation returned a non-unique type");
 	//can't be u::does_not_return, because goto can't go forward past the end of a function.
 	//we can't do this checking anymore, because not all return types are in the type hash table after GC.
 
 	auto size_of_return = get_size(return_object.type);
-	FunctionType* FT(FunctionType::get(llvm_type_including_void(size_of_return), false));
+	FunctionType* FT(FunctionType::get(llvm_type_including_void(size_of_return), std::vector<llvm::Type*>(parameter_words, llvm_i64()), false));
 	if (VERBOSE_GENERATE) print("Size of return is ", size_of_return, '\n');
 	std::string function_name = GenerateUniqueName("");
-	Function *F(Function::Create(FT, Function::ExternalLinkage, function_name, M.get())); //marking this private linkage seems to fail
+	Function *F(Function::Create(FT, Function::ExternalLinkage, function_name, M)); //marking this private linkage seems to fail
 	F->addFnAttr(Attribute::NoUnwind); //7% speedup. and required to get Orc not to leak memory, because it doesn't unregister EH frames
 
 	F->getBasicBlockList().splice(F->begin(), dummy_func->getBasicBlockList());
 	dummy_func->eraseFromParent();
+
+	//each parameter was compiled as a stack slot in the entry block. the arguments are written into the slots right after they're created.
+	auto argument = F->arg_begin();
+	for (auto& parameter : parameters)
+	{
+		llvm::Instruction* slot = llvm::cast<llvm::Instruction>(parameter.first->allocation);
+		llvm::IRBuilder<> entry_builder(slot->getNextNode());
+		for (uint64_t x = 0; x < get_size(parameter.second); ++x, ++argument)
+			entry_builder.CreateStore(&*argument, x ? entry_builder.CreateConstInBoundsGEP1_64(slot, x) : slot);
+	}
+	if (local_finiteness) spill_finiteness();
 	if (size_of_return)
 	{
 		if (size_of_return == 1) IRB->CreateRet(return_object.IR);
@@ -105,45 +197,80 @@ uint64_t compiler_object::compile_AST(uAST* target)
 		}
 	}
 	else IRB->CreateRetVoid();
+	move_escaping_targets_to_heap(); //after the return, since returning a pointer is an escape.
 #ifndef NO_CONSOLE
 	if (OUTPUT_MODULE)
 		M->print(*llvm_console, nullptr);
-	check(!llvm::verifyFunction(*F, &llvm::outs()), "verification failed");
+	{
+		trace_span span("verifyFunction");
+		check(!llvm::verifyFunction(*F, &llvm::outs()), "verification failed");
+	}
 #endif
-	if (OPTIMIZE)
+	if (optimization_level)
 	{
-		print("optimized code: \n");
-		llvm::legacy::FunctionPassManager FPM(M.get());
+		llvm::legacy::FunctionPassManager FPM(M);
 		M->setDataLayout(c->DL);
+		FPM.add(createTargetTransformInfoWrapperPass(TM->getTargetIRAnalysis())); //otherwise, the vectorizer thinks there are no vector registers.
 
-		FPM.add(createCFLAliasAnalysisPass()); //Provide basic AliasAnalysis support for GVN.
-		FPM.add(createInstructionCombiningPass()); //Do simple "peephole" optimizations and bit-twiddling optzns.
-		FPM.add(createReassociatePass()); //Reassociate expressions.
-		FPM.add(createGVNPass()); //Eliminate Common SubExpressions.
-		FPM.add(createCFGSimplificationPass()); //Simplify the control flow graph (deleting unreachable blocks, etc).
+		//create_actual_alloca makes an array for every stack object, so these come first. everything else works better on SSA values.
+		FPM.add(createSROAPass()); //Break up the alloca'd arrays.
 		FPM.add(createPromoteMemoryToRegisterPass()); //Promote allocas to registers.
 		FPM.add(createInstructionCombiningPass()); //Do simple "peephole" optimizations and bit-twiddling optzns.
-		FPM.add(createReassociatePass()); //Reassociate expressions.
-		FPM.add(createScalarReplAggregatesPass()); //I added this.
+		FPM.add(createCFGSimplificationPass()); //Simplify the control flow graph (deleting unreachable blocks, etc).
+		if (optimization_level >= 2)
+		{
+			FPM.add(createCFLAliasAnalysisPass()); //Provide basic AliasAnalysis support for GVN.
+			FPM.add(createReassociatePass()); //Reassociate expressions.
+			//labels are emitted as canonical loops, with a preheader and one latch. see label_info
+			FPM.add(createLoopRotatePass()); //Move the exit test to the bottom, which the other loop passes expect.
+			FPM.add(createLICMPass()); //Hoist loop-invariant code into the preheader.
+			FPM.add(createIndVarSimplifyPass()); //Canonicalize induction variables, and compute values on exit.
+			FPM.add(createLoopDeletionPass()); //Delete loops whose results aren't used.
+			FPM.add(createLoopUnrollPass());
+			FPM.add(createGVNPass()); //Eliminate Common SubExpressions.
+			FPM.add(createDeadStoreEliminationPass());
+			FPM.add(createLoopVectorizePass()); //uses the target's cost model, from the TargetTransformInfo pass added first.
+			FPM.add(createInstructionCombiningPass());
+			FPM.add(createCFGSimplificationPass());
+		}
 
+		trace_span span("optimization passes");
 		FPM.doInitialization();
 		FPM.run(*F);
 
-		M->print(*llvm_console, nullptr);
+#ifndef NO_CONSOLE
+		if (OUTPUT_MODULE)
+		{
+			print("optimized code: \n");
+			M->print(*llvm_console, nullptr);
+		}
+#endif
 	}
+	//a shared module is codegen'd once, so it takes the highest level that any of its functions asked for.
+	uint64_t codegen_level = CODEGEN_OPT_LEVEL != ~0ull ? CODEGEN_OPT_LEVEL : optimization_level;
+	if (codegen_level > module->codegen_level) module->codegen_level = codegen_level;
 
+	symbol_name = function_name;
 	if (!DONT_ADD_MODULE_TO_ORC)
 	{
-		if (VERBOSE_DEBUG) print("adding module...\n");
-		auto H = J.addModule(std::move(M));
+		//a batched module is added once, by compile_batch::finish().
+		//in LAZY_COMPILE mode, the IR is finished and verified, so the error code and return type are already known. only machine codegen is deferred, until the first run.
+		if (batched || (LAZY_COMPILE && !DELETE_MODULE_IMMEDIATELY))
+		{
+			if (VERBOSE_DEBUG) print("deferring module...\n");
+			fptr = nullptr;
+			return 0;
+		}
+		module->add();
 
 		// Get the address of the JIT'd function in memory.
+		trace_span span("findUnmangledSymbol"); //getAddress() is when Orc finalizes the object.
 		auto ExprSymbol = J.findUnmangledSymbol(function_name);
 
 		fptr = (void*)(intptr_t)(ExprSymbol.getAddress());
+		if (PERF_MAP) perf_map_add(module.get(), fptr, module->usage, perf_map_name(user_AST));
 
-		if (DELETE_MODULE_IMMEDIATELY) J.removeModule(H);
-		else result_module = H;
+		if (DELETE_MODULE_IMMEDIATELY) module->remove();
 	}
 	else
 	{
@@ -153,6 +280,332 @@ uint64_t compiler_object::compile_AST(uAST* target)
 }
 
 
+std::vector<std::unique_ptr<compile_scratch>> free_scratch;
+compile_scratch* compile_scratch::acquire()
+{
+	if (free_scratch.empty()) return new compile_scratch;
+	compile_scratch* s = free_scratch.back().release();
+	free_scratch.pop_back();
+	return s;
+}
+
+void compile_scratch::release(compile_scratch* s)
+{
+	s->objects.clear(); //these hold pointers into allocations, so they go first.
+	s->pointer_targets.clear();
+	s->parameters.clear();
+	s->labels.clear();
+	s->object_stack.clear();
+	s->loop_catcher.clear();
+	s->allocations.DestroyAll();
+	free_scratch.emplace_back(s);
+}
+
+//callees with at most this many ASTs are compiled into the caller, instead of being called.
+constexpr uint64_t inline_AST_limit = 32;
+
+llvm::Value* compiler_object::call_known_function(function* callee, IRemitter generic_call, Tptr argument_type, llvm::Value* arguments)
+{
+	if (callee == nullptr) return nullptr;
+	Tptr return_type = callee->return_type;
+	uint64_t size_of_return = get_size(return_type);
+	if (size_of_return > 1) return nullptr; //run_function_into() makes a trampoline for these.
+	//if the arguments don't match, generic_call returns 0 at runtime.
+	if (type_check(RVO, argument_type, callee->parameter_type) != type_check_result::perfect_fit
+		|| type_check(RVO, callee->parameter_type, argument_type) != type_check_result::perfect_fit) return nullptr;
+	uint64_t argument_words = get_size(callee->parameter_type);
+
+	//the body is compiled in if it's small, and has no run_function (which could recurse), no labels (which can't be compiled twice into one function), and nothing the caller is already using.
+	//it can't have parameters either, since those would become the caller's parameters.
+	//it also has to compile to the same type that the fptr returns. the AST can be edited after it's compiled, and then it won't.
+	uAST* body = callee->the_AST;
+	bool inline_body = body != nullptr && argument_words == 0;
+	llvm::SmallPtrSet<uAST*, 32> seen;
+	llvm::SmallVector<uAST*, 32> worklist;
+	if (body)
+	{
+		seen.insert(body);
+		worklist.push_back(body);
+	}
+	while (inline_body && !worklist.empty())
+	{
+		uAST* t = worklist.pop_back_val();
+		if (t->tag >= ASTn("never reached") || t->tag == ASTn("run_function") || t->tag == ASTn("run_function_with") || t->tag == ASTn("parameter") || t->tag == ASTn("label") || t->tag == ASTn("goto")
+			|| objects.count(t) || loop_catcher.count(t) || seen.size() > inline_AST_limit)
+			inline_body = false;
+		else for (uAST*& field : AST_range(t))
+			if (field && seen.insert(field).second) worklist.push_back(field);
+	}
+	if (inline_body)
+	{
+		AST_validator validator;
+		abstract_info validation = validator.validate(body);
+		inline_body = !validation.error_code && type_check(RVO, validation.type, return_type) == type_check_result::perfect_fit
+			&& type_check(RVO, return_type, validation.type) == type_check_result::perfect_fit;
+	}
+
+	//run_function's type is dynamic object, so both fast paths still box, and still allocate. see "doc/what to implement next"
+	auto box = [&](llvm::Value* result) -> llvm::Value*
+	{
+		if (size_of_return == 0) return llvm_integer(0);
+		if (return_type == u::dynamic_object) return result;
+		return IRB->CreateCall(llvm_int_only_func(box_return_value), {llvm_integer(return_type), result});
+	};
+	auto load_from_address = [&](void* address) -> llvm::Value*
+	{
+		return IRB->CreateLoad(IRB->CreateIntToPtr(llvm_integer((uint64_t)address), llvm_i64()->getPointerTo()));
+	};
+
+	//the fast path is only valid while the callee is what we saw at compile time. overfunc() replaces the AST, and lazy compilation and reoptimization replace the fptr.
+	//otherwise, generic_call handles it. the parameter type can't change, because overfunc() and reoptimize() keep it.
+	llvm::Value* fast_path_valid;
+	if (inline_body) fast_path_valid = IRB->CreateICmpEQ(load_from_address(&callee->the_AST), llvm_integer((uint64_t)body), s("same callee AST"));
+	else
+	{
+		fast_path_valid = IRB->CreateICmpNE(load_from_address(&callee->fptr), llvm_integer(0), s("callee has code"));
+		//while the callee is still counting runs toward reoptimization, run_function_into() does the counting.
+		if (HOT_THRESHOLD) fast_path_valid = IRB->CreateAnd(fast_path_valid, IRB->CreateICmpUGE(load_from_address(&callee->optimization_level), llvm_integer(2)));
+	}
+
+	return create_if_value(fast_path_valid,
+		[&]() -> llvm::Value*
+		{
+			//same finiteness accounting as run_function_into(). an inlined body spends from this function's finiteness directly.
+			return create_if_value(spend_finiteness(1),
+				[&]() -> llvm::Value*
+				{
+					if (inline_body)
+					{
+						Return_Info result = generate_IR(body);
+						check(result.error_code == IRgen_status::no_error, "inlined callee failed after validating");
+						return box(result.IR);
+					}
+					//the arguments go in registers, one word each, the same as compile_AST() lays out the parameters.
+					std::vector<llvm::Value*> argument_list;
+					for (uint64_t x = 0; x < argument_words; ++x)
+						argument_list.push_back(argument_words == 1 ? arguments : IRB->CreateExtractValue(arguments, {(unsigned)x}));
+					llvm::FunctionType* FT = llvm::FunctionType::get(llvm_type_including_void(size_of_return), std::vector<llvm::Type*>(argument_words, llvm_i64()), false);
+					llvm::Value* callee_fptr = IRB->CreateIntToPtr(load_from_address(&callee->fptr), FT->getPointerTo());
+					spill_finiteness();
+					llvm::Value* result = IRB->CreateCall(callee_fptr, argument_list);
+					reload_finiteness();
+					return box(result);
+				},
+				[]() -> llvm::Value* { return llvm_integer(0); });
+		},
+		generic_call);
+}
+
+//inline versions of the svector functions in vector.h, so that loops over vectors don't make a call per element, and LLVM can see the loads.
+//these must agree with the svector layout: size, then reserved_size, then the elements.
+static llvm::Value* vector_words(llvm::Value* vector) { return IRB->CreateIntToPtr(vector, llvm_i64()->getPointerTo(), s("vector")); }
+static llvm::Value* inline_vector_size(llvm::Value* vector) { return IRB->CreateLoad(vector_words(vector), s("vector size")); }
+static llvm::Value* inline_vector_element_address(llvm::Value* vector, llvm::Value* offset)
+{
+	return IRB->CreateInBoundsGEP(vector_words(vector), IRB->CreateAdd(offset, llvm_integer(vector_header_size)), s("vector element"));
+}
+
+//reference_at(): the element's address, or null if it's out of bounds.
+static llvm::Value* inline_reference_at(llvm::Value* vector, llvm::Value* offset)
+{
+	llvm::Value* in_bounds = IRB->CreateICmpULT(offset, inline_vector_size(vector), s("in bounds"));
+	return IRB->CreateSelect(in_bounds, inline_vector_element_address(vector, offset), llvm::ConstantPointerNull::get(llvm_i64()->getPointerTo()));
+}
+
+//vector_load(): the element, or 0 if it's out of bounds. this is branchless, so that loops over it can be vectorized.
+//an out of bounds offset loads element 0 instead, and discards it. vector_build() always reserves at least 3 elements, so element 0 is always there to load.
+static llvm::Value* inline_vector_load(llvm::Value* vector, llvm::Value* offset)
+{
+	llvm::Value* in_bounds = IRB->CreateICmpULT(offset, inline_vector_size(vector), s("in bounds"));
+	llvm::Value* safe_offset = IRB->CreateSelect(in_bounds, offset, llvm_integer(0));
+	llvm::Value* element = IRB->CreateLoad(inline_vector_element_address(vector, safe_offset));
+	return IRB->CreateSelect(in_bounds, element, llvm_integer(0), s("vector load"));
+}
+
+//pushback(): if there's room, the element is written in place. only reallocation calls pushback().
+//vector_slot is the i64* holding the vector, since reallocation changes it.
+static void inline_pushback(llvm::Value* vector_slot, llvm::Value* value)
+{
+	llvm::Value* vector = IRB->CreateLoad(vector_slot);
+	llvm::Value* size = inline_vector_size(vector);
+	llvm::Value* reserved_size = IRB->CreateLoad(IRB->CreateConstInBoundsGEP1_64(vector_words(vector), 1), s("reserved size"));
+
+	llvm::Function* TheFunction = IRB->GetInsertBlock()->getParent();
+	llvm::BasicBlock* InPlaceBB = llvm::BasicBlock::Create(*context, s("pushback in place"), TheFunction);
+	llvm::BasicBlock* ReallocateBB = llvm::BasicBlock::Create(*context, s("pushback reallocate"), TheFunction);
+	llvm::BasicBlock* MergeBB = llvm::BasicBlock::Create(*context, s("pushback done"), TheFunction);
+	IRB->CreateCondBr(IRB->CreateICmpULT(size, reserved_size, s("has room")), InPlaceBB, ReallocateBB);
+
+	IRB->SetInsertPoint(InPlaceBB);
+	IRB->CreateStore(value, inline_vector_element_address(vector, size));
+	IRB->CreateStore(IRB->CreateAdd(size, llvm_integer(1)), vector_words(vector));
+	IRB->CreateBr(MergeBB);
+
+	IRB->SetInsertPoint(ReallocateBB);
+	IRB->CreateCall(llvm_function(pushback, llvm_void(), llvm_i64()->getPointerTo(), llvm_i64()), {vector_slot, value});
+	IRB->CreateBr(MergeBB);
+
+	IRB->SetInsertPoint(MergeBB);
+}
+
+llvm::Value* compiler_object::cached_dynamic_subtype(uAST* site, llvm::Value* type, llvm::Value* offset)
+{
+	module->inline_caches.emplace_back(new dyn_subobj_cache(site));
+	dyn_subobj_cache* cache = module->inline_caches.back().get();
+	auto address_of = [&](uint64_t* field) { return IRB->CreateIntToPtr(llvm_integer((uint64_t)field), llvm_i64()->getPointerTo()); };
+
+	//one guard per entry. a hit is straight-line loads of the cached answer.
+	llvm::Function *TheFunction = IRB->GetInsertBlock()->getParent();
+	llvm::BasicBlock *MergeBB = llvm::BasicBlock::Create(*context, s("dyn_subobj cache merge"), TheFunction);
+	llvm::SmallVector<std::pair<llvm::Value*, llvm::BasicBlock*>, dyn_subobj_cache::polymorphic_limit + 1> results;
+	for (auto& e : cache->entries)
+	{
+		llvm::BasicBlock *HitBB = llvm::BasicBlock::Create(*context, s("dyn_subobj cache hit"), TheFunction);
+		llvm::BasicBlock *NextBB = llvm::BasicBlock::Create(*context, s(""), TheFunction);
+		llvm::Value* same_type = IRB->CreateICmpEQ(IRB->CreateLoad(address_of(&e.type)), type);
+		llvm::Value* same_offset = IRB->CreateICmpEQ(IRB->CreateLoad(address_of(&e.offset)), offset);
+		IRB->CreateCondBr(IRB->CreateAnd(same_type, same_offset, s("cache match")), HitBB, NextBB);
+
+		IRB->SetInsertPoint(HitBB);
+		llvm::Value* hits = address_of(&cache->hits);
+		IRB->CreateStore(IRB->CreateAdd(IRB->CreateLoad(hits), llvm_integer(1)), hits);
+		llvm::Value* result = llvm::UndefValue::get(double_int());
+		result = IRB->CreateInsertValue(result, IRB->CreateLoad(address_of(&e.single_type)), {0});
+		result = IRB->CreateInsertValue(result, IRB->CreateLoad(address_of(&e.switch_type)), {1});
+		IRB->CreateBr(MergeBB);
+		results.push_back({result, HitBB});
+
+		IRB->SetInsertPoint(NextBB);
+	}
+	auto miss_func = llvm_function(dyn_subobj_cache_miss, double_int(), llvm_i64(), llvm_i64(), llvm_i64());
+	llvm::Value* missed = IRB->CreateCall(miss_func, {llvm_integer((uint64_t)cache), type, offset}, s("dyn_subobj cache miss"));
+	IRB->CreateBr(MergeBB);
+	results.push_back({missed, IRB->GetInsertBlock()});
+
+	IRB->SetInsertPoint(MergeBB);
+	llvm::PHINode* type_data = IRB->CreatePHI(double_int(), results.size(), s("dynamic sub"));
+	for (auto& k : results) type_data->addIncoming(k.first, k.second);
+	return type_data;
+}
+
+llvm::AllocaInst* compiler_object::finiteness_place()
+{
+	if (local_finiteness == nullptr)
+	{
+		//the load goes right after the alloca, so it comes before every use, wherever the first use is.
+		local_finiteness = create_actual_alloca(1);
+		llvm::IRBuilder<> entry_builder(local_finiteness->getNextNode());
+		llvm::Value* global_finiteness = entry_builder.CreateIntToPtr(llvm_integer((uint64_t)&finiteness), llvm_i64()->getPointerTo());
+		entry_builder.CreateStore(entry_builder.CreateLoad(global_finiteness), local_finiteness);
+	}
+	return local_finiteness;
+}
+
+void compiler_object::spill_finiteness()
+{
+	llvm::Value* global_finiteness = IRB->CreateIntToPtr(llvm_integer((uint64_t)&finiteness), llvm_i64()->getPointerTo());
+	IRB->CreateStore(IRB->CreateLoad(finiteness_place()), global_finiteness);
+}
+
+void compiler_object::reload_finiteness()
+{
+	llvm::Value* global_finiteness = IRB->CreateIntToPtr(llvm_integer((uint64_t)&finiteness), llvm_i64()->getPointerTo());
+	IRB->CreateStore(IRB->CreateLoad(global_finiteness), finiteness_place());
+}
+
+llvm::Value* compiler_object::spend_finiteness(uint64_t cost)
+{
+	llvm::Value* place = finiteness_place();
+	if (BUDGET_MODEL == budget_model::time)
+	{
+		llvm::Function *TheFunction = IRB->GetInsertBlock()->getParent();
+		llvm::BasicBlock *RefillBB = llvm::BasicBlock::Create(*context, s("finiteness refill"), TheFunction);
+		llvm::BasicBlock *ContinueBB = llvm::BasicBlock::Create(*context, s("finiteness refilled"), TheFunction);
+		IRB->CreateCondBr(IRB->CreateICmpULT(IRB->CreateLoad(place), llvm_integer(cost), s("slice ran out")), RefillBB, ContinueBB);
+		IRB->SetInsertPoint(RefillBB);
+		spill_finiteness();
+		IRB->CreateCall(llvm_int_only_func(refill_finiteness), {});
+		reload_finiteness();
+		IRB->CreateBr(ContinueBB);
+		IRB->SetInsertPoint(ContinueBB);
+	}
+	//branchless, so that the caller decides what happens when there isn't enough.
+	llvm::Value* current_finiteness = IRB->CreateLoad(place);
+	llvm::Value* enough = IRB->CreateICmpUGE(current_finiteness, llvm_integer(cost), s("finiteness comparison"));
+	IRB->CreateStore(IRB->CreateSelect(enough, IRB->CreateSub(current_finiteness, llvm_integer(cost)), current_finiteness), place);
+	return enough;
+}
+
+//follows a pointer into one of this function's stack objects through its uses. true if it might outlive the function, or be seen by anything outside it.
+//this is deliberately primitive; any use that isn't understood is an escape. see "doc/escape analysis for removing cheap pointers.txt"
+static bool pointer_may_escape(llvm::Value* pointer, const llvm::SmallPtrSetImpl<llvm::Value*>& pointer_target_slots)
+{
+	llvm::SmallPtrSet<llvm::Value*, 16> seen;
+	llvm::SmallVector<llvm::Value*, 16> worklist;
+	auto follow = [&](llvm::Value* v) { if (seen.insert(v).second) worklist.push_back(v); };
+
+	//the pointer was stored into a stack slot. every load from the slot might be the pointer, so those are followed.
+	//if the slot's own address goes anywhere else, the pointer can be read from somewhere we can't see.
+	auto copied_into_slot = [&](llvm::Value* slot) -> bool
+	{
+		if (!llvm::isa<llvm::AllocaInst>(slot) || pointer_target_slots.count(slot)) return true;
+		if (!seen.insert(slot).second) return false;
+		llvm::SmallVector<llvm::Value*, 8> addresses{slot};
+		while (!addresses.empty())
+		{
+			llvm::Value* address = addresses.pop_back_val();
+			for (llvm::User* user : address->users())
+			{
+				if (llvm::isa<llvm::LoadInst>(user)) follow(user);
+				else if (auto store = llvm::dyn_cast<llvm::StoreInst>(user)) { if (store->getValueOperand() == address) return true; }
+				else if (llvm::isa<llvm::GetElementPtrInst>(user) || llvm::isa<llvm::BitCastInst>(user)) addresses.push_back(user);
+				else if (auto transfer = llvm::dyn_cast<llvm::MemTransferInst>(user))
+				{
+					//a bulk copy out of the slot copies the pointer into the destination, which is followed the same way. see write_into_place()
+					if (transfer->getRawSource() != address) continue;
+					llvm::Value* destination = transfer->getRawDest()->stripInBoundsConstantOffsets();
+					if (!llvm::isa<llvm::AllocaInst>(destination) || pointer_target_slots.count(destination)) return true;
+					if (seen.insert(destination).second) addresses.push_back(destination);
+				}
+				else return true;
+			}
+		}
+		return false;
+	};
+
+	follow(pointer);
+	while (!worklist.empty())
+	{
+		llvm::Value* v = worklist.pop_back_val();
+		for (llvm::User* user : v->users())
+		{
+			if (llvm::isa<llvm::IntToPtrInst>(user) || llvm::isa<llvm::PtrToIntInst>(user) || llvm::isa<llvm::BitCastInst>(user) || llvm::isa<llvm::GetElementPtrInst>(user)
+				|| llvm::isa<llvm::PHINode>(user) || llvm::isa<llvm::SelectInst>(user) || llvm::isa<llvm::InsertValueInst>(user) || llvm::isa<llvm::ExtractValueInst>(user))
+				follow(user);
+			else if (llvm::isa<llvm::LoadInst>(user) || llvm::isa<llvm::ICmpInst>(user)) continue; //loading through the pointer, or comparing it, doesn't copy it.
+			else if (auto store = llvm::dyn_cast<llvm::StoreInst>(user))
+			{
+				if (store->getValueOperand() != v) continue; //storing through the pointer
+				if (copied_into_slot(store->getPointerOperand()->stripInBoundsConstantOffsets())) return true;
+			}
+			else return true; //calls, returns, and anything else
+		}
+	}
+	return false;
+}
+
+//a pointer's target used to be moved to the heap as soon as the pointer was made. now, it stays an alloca unless the pointer escapes.
+//all the escapes are found before any target is moved, because moving one replaces its alloca.
+void compiler_object::move_escaping_targets_to_heap()
+{
+	llvm::SmallPtrSet<llvm::Value*, 8> pointer_target_slots;
+	for (auto& k : pointer_targets) pointer_target_slots.insert(k.first->allocation);
+	llvm::SmallVector<memory_allocation*, 4> escaping;
+	for (auto& k : pointer_targets)
+		if (pointer_may_escape(k.second, pointer_target_slots)) escaping.push_back(k.first);
+	for (memory_allocation* target : escaping) target->turn_full();
+}
+
 void compiler_object::emit_dtors(uint64_t desired_stack_size)
 {
 	//we can make a basic block with the instructions, then copy it over when needed.
@@ -162,8 +615,8 @@ void compiler_object::clear_stack(uint64_t desired_stack_size)
 {
 	while (object_stack.size() > desired_stack_size) //>, because desired_stack_size might be ~0ull
 	{
-		auto to_be_removed = object_stack.top();
-		object_stack.pop();
+		auto to_be_removed = object_stack.back();
+		object_stack.pop_back();
 		uint64_t number_of_erased = objects.erase(to_be_removed);
 		check(number_of_erased == 1, "erased too many or too few elements"); //we shouldn't put the erase operation in the check, because check() might be no-op'd, and erase has side effects
 		(void)number_of_erased; //here to avoid unused variable warning, in case the check disappears
@@ -228,7 +681,7 @@ Return_Info compiler_object::generate_IR(uAST* target, uint64_t stack_degree)
 	llvm::Value* default_hidden_subtype = nullptr;
 
 	//generated IR of the fields of the AST
-	std::vector<Return_Info> field_results; //we don't actually need the return code, but we leave it anyway.
+	llvm::SmallVector<Return_Info, 4> field_results; //we don't actually need the return code, but we leave it anyway.
 
 	//internal: do not call this directly. use the finish macro instead
 	//clears dead objects off the stack, and makes your result visible to other ASTs
@@ -266,8 +719,7 @@ Return_Info compiler_object::generate_IR(uAST* target, uint64_t stack_degree)
 
 			if (!existing_hidden_location)
 			{
-				allocations.push_back(memory_allocation(size_of_return));
-				default_allocation = &allocations.back();
+				default_allocation = new(allocations.Allocate()) memory_allocation(size_of_return);
 				write_into_place(return_value, default_allocation->allocation);
 			}
 
@@ -325,6 +777,13 @@ Return_Info compiler_object::generate_IR(uAST* target, uint64_t stack_degree)
 
 	//if we've seen this AST before, and we need to reprocess all its fields, then we're stuck in an infinite loop. return an error.
 	if (loop_catcher.insert(target).second == false) return_code(infinite_loop, 10); //for now, 10 is a special value, and means not any of the fields
+	++work;
+	if (PROFILE_ASTS)
+	{
+		module->AST_counters.emplace_back(target);
+		llvm::Value* counter = IRB->CreateIntToPtr(llvm_integer((uint64_t)&module->AST_counters.back().count), llvm_i64()->getPointerTo());
+		IRB->CreateStore(IRB->CreateAdd(IRB->CreateLoad(counter), llvm_integer(1)), counter);
+	}
 	//after we're done with this AST, we remove it from loop_catcher.
 	struct loop_catcher_destructor_cleanup
 	{
@@ -564,7 +1023,8 @@ Return_Info compiler_object::generate_IR(uAST* target, uint64_t stack_degree)
 
 			// Create blocks for the then and else cases. Insert the block into the function, or else it'll leak when we return_code
 			llvm::BasicBlock *label = llvm::BasicBlock::Create(*context, s("label"), TheFunction);
-			auto label_insertion = labels.insert(std::make_pair(target, label_info(label, final_stack_position, true)));
+			llvm::BasicBlock *header = llvm::BasicBlock::Create(*context, s("loop header"), TheFunction);
+			auto label_insertion = labels.insert(std::make_pair(target, label_info(label, header, final_stack_position, true, 0)));
 			if (label_insertion.second == false)
 				return_code(label_duplication, 0);
 
@@ -572,10 +1032,16 @@ Return_Info compiler_object::generate_IR(uAST* target, uint64_t stack_degree)
 			if (scoped.error_code) return scoped;
 
 			//this expires the label, so that goto knows that the label is behind. with finiteness, this means the label isn't guaranteed.
-			label_insertion.first->second.is_forward = false;
+			//the generate_IR call may have inserted other labels, which invalidates label_insertion, so we have to look it up again.
+			//the loop starts here, so a back-edge is only charged for the work after this point, not the label's interior.
+			label_info& finished = labels.find(target)->second;
+			finished.is_forward = false;
+			finished.work = work;
 
 			IRB->CreateBr(label);
 			IRB->SetInsertPoint(label);
+			IRB->CreateBr(header); //if no goto comes back, CFG simplification merges these.
+			IRB->SetInsertPoint(header);
 			finish(nullptr);
 		}
 
@@ -600,11 +1066,9 @@ Return_Info compiler_object::generate_IR(uAST* target, uint64_t stack_degree)
 				finish_special(nullptr, u::does_not_return);
 			}
 
-			//check finiteness. it's not an AllocaInst apparently (llvm asserts), because it wasn't allocated that way.
-			llvm::Value* finiteness_pointer = IRB->CreateIntToPtr(llvm_integer((uint64_t)&finiteness), llvm_i64()->getPointerTo());
-			llvm::Value* current_finiteness = IRB->CreateLoad(finiteness_pointer);
-			llvm::Value* comparison = IRB->CreateICmpNE(current_finiteness, llvm_integer(0), s("finiteness comparison"));
-
+			//check and decrease finiteness. this is the loop's back-edge, so it's where the budget is polled.
+			uint64_t cost = BUDGET_MODEL == budget_model::work ? std::max<uint64_t>(work - info.work, 1) : 1;
+			llvm::Value* comparison = spend_finiteness(cost);
 
 			llvm::Function *TheFunction = IRB->GetInsertBlock()->getParent();
 			llvm::BasicBlock *SuccessBB = llvm::BasicBlock::Create(*context, s("finiteness success"), TheFunction);
@@ -612,13 +1076,15 @@ Return_Info compiler_object::generate_IR(uAST* target, uint64_t stack_degree)
 			IRB->CreateCondBr(comparison, SuccessBB, FailureBB);
 
 			IRB->SetInsertPoint(SuccessBB);
-
-			//decrease finiteness. this comes before emission of the success branch.
-			llvm::Value* finiteness_minus_one = IRB->CreateSub(current_finiteness, llvm_integer(1));
-			IRB->CreateStore(finiteness_minus_one, finiteness_pointer);
-
 			emit_dtors(info.stack_size);
-			IRB->CreateBr(labelsearch->second.block);
+			//every goto to this label shares one latch. the finiteness check stays here, because a failed goto falls through to its own code.
+			llvm::BasicBlock*& latch = labelsearch->second.latch;
+			if (latch == nullptr)
+			{
+				latch = llvm::BasicBlock::Create(*context, s("loop latch"), TheFunction);
+				llvm::IRBuilder<>(latch).CreateBr(info.header);
+			}
+			IRB->CreateBr(latch);
 			IRB->SetInsertPoint(FailureBB);
 
 			finish(0); //whether it's a failure or not.
@@ -633,12 +1099,10 @@ Return_Info compiler_object::generate_IR(uAST* target, uint64_t stack_degree)
 			{
 				new_pointer_type = new_unique_type(Typen("temp pointer"), found_AST->second.type);
 			}
-			else
-			{
-				new_pointer_type = new_unique_type(Typen("pointer"), found_AST->second.type);
-				objects.find(target->fields[0])->second.place->turn_full();
-			}
+			else new_pointer_type = new_unique_type(Typen("pointer"), found_AST->second.type);
 			llvm::Value* final_result = IRB->CreatePtrToInt(found_AST->second.place->allocation, llvm_i64(), s("flattening pointer"));
+			//whether the target has to be full is decided once the whole function is generated. see move_escaping_targets_to_heap()
+			if (new_pointer_type.ver() == Typen("pointer")) pointer_targets.push_back({found_AST->second.place, final_result});
 			finish_special(final_result, new_pointer_type);
 		}
 	case ASTn("tmp_pointer"):
@@ -767,8 +1231,7 @@ Return_Info compiler_object::generate_IR(uAST* target, uint64_t stack_degree)
 				llvm::Value* offset_from_pointer = IRB->CreateAdd(offset, llvm_integer(1)); //skip over the type.
 				correct_pointer = IRB->CreateGEP(overall_dynamic_object, offset_from_pointer); //might not be inbounds.
 
-				auto dynamic_func = llvm_function(dynamic_subtype, double_int(), llvm_i64(), llvm_i64());
-				auto type_data = IRB->CreateCall(dynamic_func, {overall_type, offset}, s("dynamic sub"));
+				auto type_data = cached_dynamic_subtype(target, overall_type, offset);
 				single_type = IRB->CreateExtractValue(type_data, {0}, s("type of subdynamic"));
 				switch_type = IRB->CreateExtractValue(type_data, {1}, s("switch type"));
 			}
@@ -780,8 +1243,7 @@ Return_Info compiler_object::generate_IR(uAST* target, uint64_t stack_degree)
 
 				if (field_results[0].type == u::pointer_to_something)
 				{
-					auto dynamic_func = llvm_function(dynamic_subtype, double_int(), llvm_i64(), llvm_i64());
-					auto type_data = IRB->CreateCall(dynamic_func, {field_results[0].hidden_subtype, offset}, s("dynamic sub"));
+					auto type_data = cached_dynamic_subtype(target, field_results[0].hidden_subtype, offset);
 					single_type = IRB->CreateExtractValue(type_data, {0}, s("type of subdynamic"));
 					switch_type = IRB->CreateExtractValue(type_data, {1}, s("switch type"));
 
@@ -856,7 +1318,7 @@ Return_Info compiler_object::generate_IR(uAST* target, uint64_t stack_degree)
 			case Typen("vector"):
 				{
 					type_of_object = field_results[0].type.field(0);
-					reference_p = IRB->CreateCall(llvm_function(reference_at, llvm_i64()->getPointerTo(), llvm_i64(), llvm_i64()), {field_results[0].IR, field_results[1].IR});
+					reference_p = inline_reference_at(field_results[0].IR, field_results[1].IR);
 					break;
 				}
 			case Typen("AST pointer"):
@@ -894,15 +1356,14 @@ Return_Info compiler_object::generate_IR(uAST* target, uint64_t stack_degree)
 			if (field_results[0].place == nullptr) return_code(missing_reference, 0);
 			if (field_results[0].type.ver() != Typen("vector")) return_code(type_mismatch, 0);
 			if (type_check(RVO, field_results[1].type, field_results[0].type.field(0)) != type_check_result::perfect_fit) return_code(type_mismatch, 1);
-			llvm::Value* pusher = llvm_function(pushback, llvm_void(), llvm_i64()->getPointerTo(), llvm_i64());
-			IRB->CreateCall(pusher, {field_results[0].place->allocation, field_results[1].IR});
+			inline_pushback(field_results[0].place->allocation, field_results[1].IR);
 			finish(0);
 		}
 	case ASTn("vecsz"): //in the future, this should handle dynamic pointers too, and concatenates
 		{
 			if (field_results[0].type.ver() == Typen("vector") || field_results[0].type.ver() == Typen("vector of something"))
 			{
-				finish(IRB->CreateCall(llvm_int_only_func(vector_size), field_results[0].IR));
+				finish(inline_vector_size(field_results[0].IR));
 			}
 			/*else if (field_results[0].type.ver() == Typen("AST pointer"))
 			{
@@ -987,7 +1448,61 @@ Return_Info compiler_object::generate_IR(uAST* target, uint64_t stack_degree)
 			clear_stack(starting_stack_position);
 			finish(0);
 		}
-	case ASTn("run_function"): finish(IRB->CreateCall(llvm_int_only_func(run_null_parameter_function), field_results[0].IR));
+	case ASTn("run_function"):
+		{
+			IRemitter generic_call = [&]() -> llvm::Value*
+			{
+				spill_finiteness();
+				llvm::Value* result = IRB->CreateCall(llvm_int_only_func(run_null_parameter_function), field_results[0].IR);
+				reload_finiteness();
+				return result;
+			};
+			if (auto k = llvm::dyn_cast<llvm::ConstantInt>(field_results[0].IR)) //from an imv or get_event_loop
+			{
+				if (llvm::Value* result = call_known_function((function*)k->getZExtValue(), generic_call)) finish(result);
+			}
+			finish(generic_call());
+		}
+	case ASTn("run_function_with"):
+		{
+			//the generic call passes the arguments through memory, along with their type, so that the runtime can check them against the parameters.
+			Tptr argument_type = field_results[1].type;
+			uint64_t argument_words = get_size(argument_type);
+			llvm::Value* argument_address = llvm_integer(0);
+			if (argument_words)
+			{
+				llvm::Value* argument_slot = create_actual_alloca(argument_words);
+				write_into_place(field_results[1].IR, argument_slot);
+				argument_address = IRB->CreatePtrToInt(argument_slot, llvm_i64());
+			}
+			IRemitter generic_call = [&]() -> llvm::Value*
+			{
+				spill_finiteness();
+				llvm::Value* result = IRB->CreateCall(llvm_int_only_func(run_function_with_arguments), {field_results[0].IR, llvm_integer(argument_type), argument_address});
+				reload_finiteness();
+				return result;
+			};
+			if (auto k = llvm::dyn_cast<llvm::ConstantInt>(field_results[0].IR))
+			{
+				if (llvm::Value* result = call_known_function((function*)k->getZExtValue(), generic_call, argument_type, field_results[1].IR)) finish(result);
+			}
+			finish(generic_call());
+		}
+	case ASTn("parameter"):
+		{
+			auto k = llvm::dyn_cast<llvm::ConstantInt>(field_results[0].IR);
+			if (!k) return_code(requires_constant, 0);
+			Tptr parameter_type = (Tptr)k->getZExtValue();
+			uint64_t size = get_size(parameter_type);
+			if (size == 0) return_code(type_mismatch, 0);
+			if (parameter_words + size > max_parameter_words) return_code(too_many_parameters, 0);
+			parameter_words += size;
+
+			//like load_subobj, the result is a reference to the slot, so it can be stored into but not pointed to.
+			default_allocation = new(allocations.Allocate()) memory_allocation(size);
+			parameters.push_back({default_allocation, parameter_type});
+			finish_special(load_from_memory(default_allocation->allocation, size), parameter_type);
+		}
 	case ASTn("imv"): //bakes in the value into the compiled function. changes by the function are temporary.
 		{
 			uint64_t* dynamic_object = (uint64_t*)target->fields[0];
@@ -1040,7 +1555,7 @@ Return_Info compiler_object::generate_IR(uAST* target, uint64_t stack_degree)
 				finish_special(IRB->CreateCall(llvm_int_only_func(AST_subfield_guarantee), {field_results[0].IR, field_results[1].IR}), u::AST_pointer);
 			case Typen("vector"):
 				if (!is_zeroable(field_results[0].type.field(0))) return_code(type_mismatch, 0);
-				finish_special(IRB->CreateCall(llvm_int_only_func(vector_load), {field_results[0].IR, field_results[1].IR}), field_results[0].type.field(0));
+				finish_special(inline_vector_load(field_results[0].IR, field_results[1].IR), field_results[0].type.field(0));
 			case Typen("function pointer"):
 				if (auto k = llvm::dyn_cast<llvm::ConstantInt>(field_results[1].IR)) //we need the second field to be a constant.
 				{
@@ -1085,6 +1600,7 @@ Return_Info compiler_object::generate_IR(uAST* target, uint64_t stack_degree)
 		}
 	case ASTn("system1"):
 		{
+			spill_finiteness(); //system1 [imv 1] reads it.
 			llvm::CallInst* systemquery = IRB->CreateCall(llvm_int_only_func(system1), field_results[0].IR);
 			systemquery->addAttribute(llvm::AttributeSet::FunctionIndex, llvm::Attribute::NoUnwind);
 			systemquery->addAttribute(llvm::AttributeSet::FunctionIndex, llvm::Attribute::ReadOnly);
@@ -1113,6 +1629,10 @@ Return_Info compiler_object::generate_IR(uAST* target, uint64_t stack_degree)
 		{
 			finish(llvm_integer((uint64_t)event_roots.at(0)));
 		}
+	case ASTn("optimize"):
+		{
+			finish(IRB->CreateCall(llvm_int_only_func(optimize_AST), field_results[0].IR, s("optimize")));
+		}
 	default:
 		error("no switch");
 	}
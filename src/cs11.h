@@ -1,14 +1,18 @@
 #pragma once
 #include <llvm/IR/DerivedTypes.h>
 #include <llvm/IR/IRBuilder.h>
-#include <unordered_set>
 #include <unordered_map>
 #include <vector>
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/SmallPtrSet.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/Support/Allocator.h>
 #include <llvm/IR/LLVMContext.h>
 #include <llvm/IR/Module.h>
 #include <llvm/IR/Verifier.h>
 #include <llvm/Transforms/Utils/BasicBlockUtils.h>
 #include <random>
+#include <chrono>
 #include "types.h"
 #include "ASTs.h"
 #include "orc.h"
@@ -18,6 +22,22 @@
 extern std::mt19937_64 mersenne;
 extern uint64_t finiteness;
 constexpr uint64_t FINITENESS_LIMIT = 10;
+
+/* how finiteness is spent. a compiled function keeps finiteness in a local, which it spends at backward gotos and calls, and writes back around calls and at the return.
+	calls: each call and each backward goto costs 1.
+	work: a backward goto costs the number of ASTs compiled between its label and it, so long loops are charged for their length. calls cost 1.
+	time: costs are the same as calls, but finiteness is a slice of polls. when a slice runs out, refill_finiteness() reads the clock and starts another, until finiteness_deadline.
+the model is read when compiling, so it's baked into the function.
+*/
+enum class budget_model : uint64_t { calls, work, time };
+extern budget_model BUDGET_MODEL;
+extern uint64_t TIME_LIMIT_MICROSECONDS; //the time model's budget for one run.
+constexpr uint64_t WORK_LIMIT = 1000; //the work model's budget for one run, in ASTs.
+constexpr uint64_t TIME_SLICE = 1000; //the time model's polls between clock reads.
+extern std::chrono::steady_clock::time_point finiteness_deadline;
+void start_finiteness_budget(); //sets finiteness for a new run, according to BUDGET_MODEL.
+uint64_t refill_finiteness(); //called when finiteness runs out. returns the new finiteness, which is 0 unless the time model has time left.
+constexpr uint64_t max_parameter_words = 6; //parameters are passed one word per argument, and x86-64 has 6 integer argument registers.
 uint64_t generate_exponential_dist();
 
 
@@ -28,21 +48,54 @@ struct function;
 extern std::vector< function*> event_roots; //in our current iteration, we force this to have size exactly 1. it cannot be nullptr.
 extern std::vector< Tptr > type_roots;
 
+//a label is emitted as a natural loop in canonical form, so that LLVM's loop passes recognize it.
+//falling into the label and forward gotos go to the preheader. backward gotos go through the single latch, which is the loop's only back-edge.
+struct label_info
+{
+	llvm::BasicBlock* block; //the preheader
+	llvm::BasicBlock* header;
+	llvm::BasicBlock* latch = nullptr; //created by the first backward goto.
+	uint64_t stack_size;
+	bool is_forward; //set to 1 on creation, then to 0 after you finish the label's interior.
+	uint64_t work; //ASTs compiled before the loop header, which comes after the interior. a backward goto costs the difference, under the work model.
+	label_info(llvm::BasicBlock* l, llvm::BasicBlock* h, uint64_t s, bool f, uint64_t w) : block(l), header(h), stack_size(s), is_forward(f), work(w) {}
+};
+
+//the containers used during a compilation. most compilations are small and most fuzzer compilations fail, so allocating these fresh each time was a large part of the cost.
+//instead, compiler_objects borrow one from a free list, and it's reset rather than freed when they're done. the flat maps and small vectors keep their memory through a reset.
+struct compile_scratch
+{
+	llvm::SpecificBumpPtrAllocator<memory_allocation> allocations; //pointers must remain valid, so this is an arena.
+	llvm::SmallPtrSet<uAST*, 32> loop_catcher;
+	llvm::SmallVector<uAST*, 32> object_stack;
+	llvm::DenseMap<uAST*, Return_Info> objects;
+	llvm::DenseMap<uAST*, label_info> labels;
+	llvm::SmallVector<std::pair<memory_allocation*, llvm::Value*>, 4> pointer_targets;
+	llvm::SmallVector<std::pair<memory_allocation*, Tptr>, 4> parameters;
+
+	static compile_scratch* acquire();
+	static void release(compile_scratch* s); //resets s, then puts it on the free list.
+};
+
 class compiler_object
 {
 	KaleidoscopeJIT& J;
+	bool batched; //if true, the module is shared, and compile_batch adds it to Orc.
+	uint64_t optimization_level;
 
-	std::deque<memory_allocation> allocations; //deque, because pointers need to remain valid. must be above std::unordered_map objects, because the Return_Info has dtors that reference this
+	compile_scratch* scratch; //must be above the references into it.
+	llvm::SpecificBumpPtrAllocator<memory_allocation>& allocations;
 
 	//lists the ASTs we're currently looking at. goal is to prevent infinite loops.
-	std::unordered_set<uAST*> loop_catcher;
+	llvm::SmallPtrSet<uAST*, 32>& loop_catcher;
 
 	//a stack for bookkeeping lifetimes; keeps track of when objects are alive.
 	//we insert a stack element here whenever we succeed at adding an AST to <>objects.
-	std::stack<uAST*> object_stack;
+	llvm::SmallVector<uAST*, 32>& object_stack;
 
 	//maps ASTs to their generated IR and return type.
-	std::unordered_map<uAST*, Return_Info> objects;
+	//DenseMap invalidates iterators on insertion, so don't hold an iterator across a generate_IR() call.
+	llvm::DenseMap<uAST*, Return_Info>& objects;
 
 	//pair with clear_stack().
 	void new_living_object(uAST* target, Return_Info r)
@@ -51,19 +104,12 @@ class compiler_object
 		auto insert_result = objects.insert({target, r});
 		if (!insert_result.second) //collision: AST is already there
 			return;
-		object_stack.push(target);
+		object_stack.push_back(target);
 		return;
 	}
 
-	struct label_info
-	{
-		llvm::BasicBlock* block;
-		uint64_t stack_size;
-		bool is_forward; //set to 1 on creation, then to 0 after you finish the label's interior.
-		label_info(llvm::BasicBlock* l, uint64_t s, bool f) : block(l), stack_size(s), is_forward(f) {}
-	};
 	//these are labels which can be jumped to. the basic block, and the object stack.
-	std::map<uAST*, label_info> labels;
+	llvm::DenseMap<uAST*, label_info>& labels;
 
 	//some objects have expired - this clears them
 	void clear_stack(uint64_t desired_stack_size);
@@ -71,8 +117,7 @@ class compiler_object
 	void emit_dtors(uint64_t desired_stack_size);
 	memory_allocation* new_reference(llvm::Value* IR)
 	{
-		allocations.push_back(IR);
-		return &allocations.back();
+		return new(allocations.Allocate()) memory_allocation(IR);
 	}
 
 	using IRemitter = std::function<llvm::Value*()>;
@@ -120,9 +165,38 @@ class compiler_object
 	}
 
 	Return_Info generate_IR(uAST* user_target, uint64_t stack_degree = 0);
+
+	//run_function or run_function_with on a function object that's a compile-time constant. returns nullptr if it can't be specialized; then, the caller emits generic_call instead.
+	//generic_call is also emitted as the runtime fallback, if the callee changes after this compilation.
+	llvm::Value* call_known_function(function* callee, IRemitter generic_call, Tptr argument_type = 0, llvm::Value* arguments = nullptr);
+
+	//dynamic_subtype() for a dyn_subobj site, through a new inline cache. returns the same {single type, switch type} pair. see inline_cache.h
+	llvm::Value* cached_dynamic_subtype(uAST* site, llvm::Value* type, llvm::Value* offset);
+
+	//each pointer AST's target, and the pointer's IR. compile_AST() moves a target to the heap only if its pointer escapes the function.
+	llvm::SmallVector<std::pair<memory_allocation*, llvm::Value*>, 4>& pointer_targets;
+	void move_escaping_targets_to_heap();
+
+	//the function's copy of finiteness. it's loaded in the entry block, and written back to the global around calls and at the return. see budget_model
+	llvm::AllocaInst* local_finiteness = nullptr;
+	llvm::AllocaInst* finiteness_place();
+	void spill_finiteness(); //before a call that reads or spends finiteness
+	void reload_finiteness(); //after a call that might have spent finiteness
+	//returns whether there was enough finiteness, and spends it if so. under the time model, it refills an empty slice first.
+	llvm::Value* spend_finiteness(uint64_t cost);
+	uint64_t work = 0; //ASTs compiled so far, for the work model.
+
+	//the parameter ASTs compiled so far, in order, with their stack slots. compile_AST() writes the arguments into the slots on entry.
+	llvm::SmallVector<std::pair<memory_allocation*, Tptr>, 4>& parameters;
+	uint64_t parameter_words = 0;
 	
 public:
-	compiler_object() : J(*c), error_location(nullptr), return_type(0), new_context(new llvm::LLVMContext()) {}
+	//if batch is nonzero, compilation goes into that shared module, and the caller is responsible for adding it to Orc. see compile_batch.
+	compiler_object(std::shared_ptr<jit_module> batch = nullptr, uint64_t level = OPTIMIZATION_LEVEL) : J(*c), batched(batch != nullptr), optimization_level(level),
+		scratch(compile_scratch::acquire()), allocations(scratch->allocations), loop_catcher(scratch->loop_catcher), object_stack(scratch->object_stack), objects(scratch->objects), labels(scratch->labels),
+		pointer_targets(scratch->pointer_targets), parameters(scratch->parameters),
+		error_location(nullptr), return_type(0), module(std::move(batch)) {}
+	~compiler_object() { compile_scratch::release(scratch); }
 	uint64_t compile_AST(uAST* target); //we can't combine this with the ctor, because it needs to return an int
 
 	void* fptr; //the end fptr.
@@ -132,10 +206,8 @@ public:
 	uint64_t error_field; //which field in error_location has the error
 
 	//these exist on successful compilation. guaranteed to be uniqued and in the heap.
-	//currently, parameters are not implemented
 	Tptr return_type;
-	Tptr parameter_type = 0;
-	KaleidoscopeJIT::ModuleHandleT result_module;
-
-	std::unique_ptr<llvm::LLVMContext> new_context;
+	Tptr parameter_type = 0; //the concatenation of the parameter types, or 0 if there are none.
+	std::string symbol_name; //fptr can be found from this, once the module is added.
+	std::shared_ptr<jit_module> module; //if not batched, compile_AST() creates this once the AST passes validation.
 };
\ No newline at end of file
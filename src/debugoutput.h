@@ -143,7 +143,7 @@ struct output_AST_struct
 		bool printed_reference = false;
 		if (AST_list.find(target) != AST_list.end())
 		{
-			print(target);
+			output << target;
 			return;
 		}
 		else
@@ -151,7 +151,7 @@ struct output_AST_struct
 			AST_list.insert(target);
 			if (reference_necessary.find(target) != reference_necessary.end())
 			{
-				print('_', target);
+				output << '_' << target;
 				printed_reference = true;
 			}
 		}
@@ -160,10 +160,10 @@ struct output_AST_struct
 		{
 			auto& xvec = target->BBvec();
 			if ((printed_reference || xvec->size > 1) && braces_allowed) //we print it no matter what, in case 
-				print("{");
+				output << "{";
 			if (xvec->size == 0)
 			{
-				print("0");
+				output << "0";
 				return;
 			}
 			else
@@ -171,28 +171,33 @@ struct output_AST_struct
 				bool first = true;
 				for (auto& x : Vector_range(xvec))
 				{
-					if (first == false) print(" ");
+					if (first == false) output << " ";
 					first = false;
 					output_output((uAST*)x, true);
 				}
 			}
 			if ((printed_reference || xvec->size > 1) && braces_allowed)
-				print("}");
+				output << "}";
 		}
 		else
 		{
-			print("[", AST_descriptor[target->tag].name);
+			output << "[" << AST_descriptor[target->tag].name;
 			uint64_t x = 0;
 			for (; x < AST_descriptor[target->tag].pointer_fields; ++x)
 			{
-				print(' ');
+				output << ' ';
 				output_output(target->fields[x], true);
 			}
 
-			//any additional fields that aren't pointers
+			//any additional fields that aren't pointers.
+			//an imv's field is a dynamic object: its type, then its value. if it's an integer, the value is printed, so that the reader can read it back.
 			for (; x < get_field_size_of_AST(target->tag); ++x)
-				print(' ', target->fields[x]);
-			print(']');
+			{
+				uint64_t* object = (uint64_t*)target->fields[x];
+				if (target->tag == ASTn("imv") && object && Tptr(object[0]) != 0 && Tptr(object[0]).ver() == Typen("integer")) output << ' ' << object[1];
+				else output << ' ' << target->fields[x];
+			}
+			output << ']';
 		}
 	}
 };
@@ -12,15 +12,17 @@ struct function
 	uAST* the_AST;
 	Tptr return_type;
 	Tptr parameter_type = 0; //if nonzero, change the mark algorithm
-	void* fptr; //the function pointer
-	KaleidoscopeJIT::ModuleHandleT result_module;
-	std::unique_ptr<llvm::LLVMContext> context;
+	void* fptr; //the function pointer. nullptr if the function hasn't been codegen'd yet.
+	std::shared_ptr<jit_module> module; //possibly shared with other functions from the same compile batch.
+	std::string symbol_name; //used to find fptr once the module is added.
+	uint64_t optimization_level; //what level the current fptr was compiled at
+	uint64_t run_count = 0; //for hotness-based reoptimization
 	//todo: finiteness
 	//function() { the_AST = (uAST*)(this - 1); return_type = (Tptr)(this + 1); } //initializing the doubly-linked list.
-	function(uAST* a, Tptr r, Tptr p, void* f, KaleidoscopeJIT::ModuleHandleT m, std::unique_ptr<llvm::LLVMContext> c)
-		: the_AST(a), return_type(r), parameter_type(p), fptr(f), result_module(m), context(std::move(c))
+	function(uAST* a, Tptr r, Tptr p, void* f, std::shared_ptr<jit_module> m, std::string n, uint64_t o = OPTIMIZATION_LEVEL)
+		: the_AST(a), return_type(r), parameter_type(p), fptr(f), module(std::move(m)), symbol_name(std::move(n)), optimization_level(o)
 	{
-		if (OUTPUT_ASSEMBLY)
+		if (OUTPUT_ASSEMBLY && fptr)
 		{
 			print("fptr at ", fptr, ": ");
 			for (int x = 0; x < 100; ++x)
@@ -30,19 +32,28 @@ struct function
 			}
 		}
 	}
+
+	//codegens the module if it hasn't been already, then patches fptr, so that later runs go straight to the code.
+	//used by lazy compilation on the first run, and by compile batches when they finish.
+	void materialize()
+	{
+		if (VERBOSE_DEBUG) print("materializing ", symbol_name, '\n');
+		if (module->pending) module->add();
+		trace_span span("findUnmangledSymbol");
+		fptr = (void*)(intptr_t)(c->findUnmangledSymbol(symbol_name).getAddress());
+		if (PERF_MAP) perf_map_add(module.get(), fptr, module->usage, perf_map_name(the_AST));
+	}
+
 	~function()
 	{
-		if (!DONT_ADD_MODULE_TO_ORC && !DELETE_MODULE_IMMEDIATELY)
-		{
-			if (VERBOSE_GC) print("removing module, where this is ", this, "\n");
-			c->removeModule(result_module);
-		}
+		if (VERBOSE_GC && module.use_count() == 1) print("removing module, where this is ", this, "\n");
 	}
 };
 
+//the code bytes are the whole module's. a compile_batch puts many functions in one module, and they all print the batch's total.
 inline std::ostream& operator<< (std::ostream& o, const function& fred)
 {
-	return o << "function at " << &fred << " with AST " << fred.the_AST << " return " << fred.return_type << " fptr " << fred.fptr << '\n';
+	return o << "function at " << &fred << " with AST " << fred.the_AST << " return " << fred.return_type << " fptr " << fred.fptr << " module code bytes " << fred.module->usage.code_bytes << '\n';
 }
 
 function* allocate_function();
\ No newline at end of file
@@ -1,6 +1,9 @@
+#pragma once
 #include "globalinfo.h" //for check()
 #include <llvm/ADT/ArrayRef.h>
 #include <atomic>
+#include <string>
+#include <thread>
 #include <unistd.h>
 #include <sys/mman.h>
 #include <sys/types.h>
@@ -9,7 +12,7 @@
 #include <fcntl.h>           /* For O_* constants */
 
 //we assume that users cannot crash in the middle of writing to a queue. that's very optimistic. what if the admin decides to send a kill-message?
-extern uint64_t mmap_size;
+extern uint64_t mmap_size; //in bytes. queue offsets are in words.
 constexpr uint64_t ssqh_size = 2; //single sender queue header size
 
 enum events
@@ -20,6 +23,8 @@ enum events
 	existence_ping, //from a user to the admin, telling the admin that the user still exists.
 	aliveness_check, //from admin to user. requesting a ping.
 	panic, //from anyone to anyone. forces everyone to shut down and serialize. used on bug event. unimplemented
+	shared_AST, //from a farm worker to the others. the AST's length in bytes, then its console format, packed into words. see comms.h
+	farm_stats, //from a farm worker to the admin. the worker number, its total iterations, the number of tags, then its hitcount for each tag.
 };
 /*
 //nobody is a single sender queue anymore. because both the king and the admin can send messages.
@@ -111,6 +116,8 @@ struct single_sender_queue
 
 constexpr uint64_t msqh_size = 3; //_multiple_ sender queue header size. sender reserve, then sender size, then user size.
 
+//one word is always left empty, so that a full queue doesn't look the same as an empty one.
+//messages are committed in the order they were reserved, so a receiver that sees the first word of a message can read all of it.
 struct multiple_sender_queue
 {
 	multiple_sender_queue() : memory_location((std::atomic<uint64_t>*)53535) {}
@@ -122,20 +129,24 @@ struct multiple_sender_queue
 	}
 	std::atomic<uint64_t>* memory_location;
 
-	//these are offsets from the base. so starting value gives 2.
+	//these are offsets from the base. so starting value gives 3.
 	std::atomic<uint64_t>& sender_reserve_position() { return memory_location[0]; }
 	std::atomic<uint64_t>& sender_done_position() { return memory_location[1]; }
 	std::atomic<uint64_t>& user_position() { return memory_location[2]; }
 
+	uint64_t queue_end() { return mmap_size / sizeof(uint64_t); }
+	uint64_t capacity() { return queue_end() - msqh_size; }
+	uint64_t wrap(uint64_t offset) { return offset >= queue_end() ? offset - capacity() : offset; }
+	//performs the wraparound. get offsets one by one.
+	inline uint64_t next_offset(uint64_t offset) { return wrap(offset + 1); }
+
 	//use the receiver
 	uint64_t get_next_value()
 	{
 		uint64_t offset = user_position().load();
-		uint64_t* raw_area = (uint64_t*)memory_location; //bypass the locks; the only atomic elements are the first two.
+		uint64_t* raw_area = (uint64_t*)memory_location; //bypass the locks; the only atomic elements are the header.
 		uint64_t loaded_integer = raw_area[offset];
-		if (offset > mmap_size) offset = msqh_size; //the starting position.
-		else ++offset;
-		user_position().store(offset);
+		user_position().store(next_offset(offset));
 		return loaded_integer;
 	}
 
@@ -145,55 +156,38 @@ struct multiple_sender_queue
 		return (sender_done_position() != offset);
 	}
 
-	//allocates memory to be sent. the memory region might be split in half. thus, you must use next_offset.
+	//reserves memory to be sent. the memory region might be split in half. thus, you must use next_offset.
 	//rationale: it's important to have sender and receiver agree on where the next relevant element is located.
-	uint64_t allocate_memory(uint64_t elements)
+	//returns false if the receiver hasn't read enough to make room. then, nothing is reserved.
+	bool allocate_memory(uint64_t elements, uint64_t& starting_position)
 	{
-		check(elements < mmap_size - msqh_size - 20, "allocating excessive memory");
-		uint64_t starting_position = sender_reserve_position().load();
-		try_again: //starting position was loaded by the compxchg, so we don't need to reload.
-		uint64_t user_GC_boundary = user_position().load();
-		if (user_GC_boundary < starting_position)
-			user_GC_boundary += mmap_size - msqh_size; //here, we reorder things so that they're in a straight line, instead of modulo.
-		if ((user_GC_boundary > starting_position) && (user_GC_boundary < starting_position + elements))
-		{
-			//todo. we've run out of memory. here, the admin would kill the process for not receiving memory.
-			//but the user should abort(), for stuffing too much information.
-		}
-		uint64_t ending_location = starting_position + elements;
-		if (ending_location >= mmap_size)
+		check(elements < capacity(), "allocating excessive memory");
+		starting_position = sender_reserve_position().load();
+		do //starting position is reloaded by the compxchg when it fails.
 		{
-			ending_location -= (mmap_size - msqh_size); //wraparound
-		}
-		if (!sender_reserve_position().compare_exchange_weak(starting_position, ending_location))
-			goto try_again;
-		return starting_position;
-	}
-	//performs the wraparound. get offsets one by one.
-	inline uint64_t next_offset(uint64_t offset)
-	{
-		return (offset + 1 == mmap_size) ? msqh_size : offset + 1;
+			uint64_t used = (starting_position + capacity() - user_position().load()) % capacity();
+			if (used + elements >= capacity()) return false;
+		} while (!sender_reserve_position().compare_exchange_weak(starting_position, wrap(starting_position + elements)));
+		return true;
 	}
 
+	//waits for the senders that reserved earlier, so that messages become visible in order.
 	void commit_memory(uint64_t initial_offset, uint64_t size_of_memory)
 	{
-		uint64_t final_offset = initial_offset + size_of_memory;
+		uint64_t final_offset = wrap(initial_offset + size_of_memory);
 		uint64_t initial_offset_temp = initial_offset;
-		if (final_offset > mmap_size) final_offset -= (mmap_size - msqh_size);
 		while (!sender_done_position().compare_exchange_weak(initial_offset_temp, final_offset))
 		{
 			initial_offset_temp = initial_offset;
 		};
 	}
 
-
-	void write_values(llvm::ArrayRef<uint64_t> values)
+	//returns false without writing if the queue is full.
+	bool try_write_values(llvm::ArrayRef<uint64_t> values)
 	{
 		check(values.size() > 0, "writing no values");
-		check(values.size() < mmap_size - msqh_size - 20, "allocating excessive memory");
-
-
-		uint64_t new_mem_offset = allocate_memory(values.size()); //I don't think this actually needs to be atomic
+		uint64_t new_mem_offset;
+		if (!allocate_memory(values.size(), new_mem_offset)) return false;
 		uint64_t original_mem_offset = new_mem_offset;
 		*(uint64_t*)(&memory_location[new_mem_offset]) = values[0];
 		for (uint64_t x = 1; x < values.size(); ++x)
@@ -203,39 +197,49 @@ struct multiple_sender_queue
 		}
 
 		commit_memory(original_mem_offset, values.size());
+		return true;
+	}
+
+	//waits until the receiver makes room.
+	void write_values(llvm::ArrayRef<uint64_t> values)
+	{
+		while (!try_write_values(values))
+			std::this_thread::yield();
 	}
 };
 
 //set mmap size first
-void* allocate_shm(uint64_t id)
+inline void* allocate_shm(uint64_t id)
 {
 	//std::cerr << "file ID in parent is " << file_ID << '\n';
 	int descriptor = -1;
 	int mmap_flags = MAP_SHARED;
-	const char* file_ID = (std::string("/") + std::to_string(id)).c_str();
+	std::string file_ID = std::string("/") + std::to_string(id); //a string, not a c_str() of a temporary, which would dangle.
 
 	//open the shared memory.
-	descriptor = shm_open(file_ID, O_CREAT | O_RDWR, S_IRUSR | S_IWUSR);
+	descriptor = shm_open(file_ID.c_str(), O_CREAT | O_RDWR, S_IRUSR | S_IWUSR);
 	check(descriptor != -1, "descriptor fail");
 
 	//size up the shared memory. it'll be 0's.
-	ftruncate(descriptor, mmap_size);
+	if (ftruncate(descriptor, mmap_size) == -1) error("ftruncate fail"); //not check(), which doesn't run its expression under NOCHECK.
 
 	void *mmap_result = mmap(NULL, mmap_size, PROT_WRITE | PROT_READ, mmap_flags, descriptor, 0);
 	check(mmap_result != MAP_FAILED, "map failed");
+	close(descriptor); //the mapping stays.
 	return mmap_result;
 }
 
 //set mmap size first
-void* open_memory(uint64_t id)
+inline void* open_memory(uint64_t id)
 {
 	int descriptor = -1;
 	int mmap_flags = MAP_SHARED;
-	const char* file_ID = (std::string("/") + std::to_string(id)).c_str();
-	descriptor = shm_open(file_ID, O_RDWR, S_IRUSR | S_IWUSR);
+	std::string file_ID = std::string("/") + std::to_string(id);
+	descriptor = shm_open(file_ID.c_str(), O_RDWR, S_IRUSR | S_IWUSR);
 	check(descriptor != -1, "descriptor fail");
 
 	void *mmap_result = mmap(NULL, mmap_size, PROT_WRITE | PROT_READ, mmap_flags, descriptor, 0);
 	check(mmap_result != MAP_FAILED, "map failed");
+	close(descriptor);
 	return mmap_result;
-}
\ No newline at end of file
+}
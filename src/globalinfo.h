@@ -4,41 +4,61 @@
 #include <llvm/Support/raw_ostream.h> 
 #include <llvm/IR/LLVMContext.h>
 #include <llvm/IR/IRBuilder.h>
+#include "log.h"
 
 extern llvm::raw_ostream* llvm_console;
 using std::string;
 extern bool QUIET;
-extern bool OPTIMIZE;
+extern uint64_t OPTIMIZATION_LEVEL; //default IR optimization level for compiles. 0, 1, or 2. level 1 and up also run the AST optimizer.
+extern uint64_t CODEGEN_OPT_LEVEL; //llvm::CodeGenOpt::Level, or ~0ull to follow the IR level.
+extern uint64_t HOT_THRESHOLD; //after this many runs, a function is recompiled at level 2. 0 turns this off, and is the default. the recompile happens inside the run that crosses it.
 extern bool INTERACTIVE;
 extern bool CONSOLE;
 extern bool TIMER;
 extern bool DONT_ADD_MODULE_TO_ORC;
 extern bool DELETE_MODULE_IMMEDIATELY;
+extern bool LAZY_COMPILE; //if true, codegen is deferred until a function is first run. see function::materialize()
+extern bool VALIDATOR_CROSSCHECK; //if true, compile_AST() runs both the validator and generate_IR(), and checks that they agree. see validator.h
+extern bool PERF_MAP; //if true, JIT'd functions are listed in /tmp/perf-<pid>.map, so that perf can name them. see perf_map.h
+extern bool FUZZ_GUIDED; //if true, the compiler and runtime record features, and the fuzzer favors what finds new ones. see coverage.h
+extern bool PROFILE_ASTS; //if true, compiled code counts how many times each AST runs, and the counts are printed at exit. see profile.h
+extern bool INLINE_CACHE_STATS; //if true, prints each dyn_subobj inline cache's hits and misses at exit, instead of just the totals. see inline_cache.h
+extern bool AST_OPTIMIZE; //if true, compile_AST() runs the AST optimizer even at optimization level 0. see optimizer.h
 extern bool OUTPUT_MODULE;
 extern bool SERIALIZE_ON_EXIT;
 constexpr bool HEURISTIC = false; //heuristically gives errors. for example, large objects are assumed to be bad.
 
 
 #ifndef NO_CONSOLE
-inline void print(){}
+inline void log_arguments(std::ostream& o){}
 
 template<typename First, typename ...Rest>
-inline void print(First && first, Rest && ...rest)
+inline void log_arguments(std::ostream& o, First && first, Rest && ...rest)
 {
-	if (!QUIET)
-	{
-		std::cerr << std::forward<First>(first);
-		print(std::forward<Rest>(rest)...);
-	}
+	o << std::forward<First>(first);
+	log_arguments(o, std::forward<Rest>(rest)...);
 }
+
+//QUIET and the level are checked before anything is formatted or locked. see log.h
+template<typename ...Arguments>
+inline void print_at(log_level level, Arguments && ...arguments)
+{
+	if (QUIET || level < LOG_LEVEL) return;
+	log_writer writer;
+	log_arguments(writer.stream, std::forward<Arguments>(arguments)...);
+}
+
+template<typename ...Arguments>
+inline void print(Arguments && ...arguments) { print_at(log_level::info, std::forward<Arguments>(arguments)...); }
 #else
 #define QUIET true
 template<typename ...Rubbish> inline void print(Rubbish && ...rest){}
+template<typename ...Rubbish> inline void print_at(log_level level, Rubbish && ...rest){}
 #endif
 
 extern bool VERBOSE_DEBUG;
 //llvm::StringRef disallowed because cout can't take it
-[[noreturn]] inline constexpr void error(const string& Str) { std::cerr << "Error: " << Str << '\n'; abort(); } //std::cerr, because we want error messages even when default console output (print) is turned off.
+[[noreturn]] inline constexpr void error(const string& Str) { flush_log(); std::cerr << "Error: " << Str << '\n'; abort(); } //std::cerr, because we want error messages even when default console output (print) is turned off. the log is flushed first, so the error comes after what was printed before it.
 //later, we'll want it to work in a big way by logging and everything. and then we'll have "small errors", for OOM and such.
 
 
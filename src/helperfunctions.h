@@ -25,6 +25,7 @@ enum IRgen_status {
 	error_transfer_from_if, //our if function can't transfer error codes. they get lost. so we return this error instead.
 	lost_hidden_subtype, //when working with a pointer to something, you need its true type lying around in runtime. if this true type is lost, the object becomes useless.
 	nonfull_object, //tried to move a temporary stack object to the heap.
+	too_many_parameters, //the function's parameters don't fit in the argument registers.
 };
 
 //solely for convenience
@@ -179,6 +180,22 @@ struct value_collection
 	value_collection(std::vector<llvm::Value*> a) : objects{a} {}
 };
 
+//objects at least this big are moved whole: one load or store of the array, or a memcpy, instead of one per word. the backend lowers these to vector moves.
+//4 words is one AVX register.
+constexpr uint64_t bulk_copy_threshold = 4;
+
+//if value is a whole-object load, and nothing since then can have written to memory, returns the address it was loaded from.
+//then, copying the value is a copy from that address.
+inline llvm::Value* unchanged_source(llvm::Value* value)
+{
+	auto load = llvm::dyn_cast<llvm::LoadInst>(value);
+	if (!load || load->getParent() != IRB->GetInsertBlock()) return nullptr;
+	llvm::BasicBlock::iterator i(load);
+	for (++i; i != IRB->GetInsertPoint(); ++i)
+		if (i->mayWriteToMemory()) return nullptr;
+	return load->getPointerOperand();
+}
+
 //the ssa bool is in case the target is an array/integer. in that case, "target" is overwritten.
 inline void write_into_place(value_collection data, llvm::Value*& target, bool ssa = false)
 {
@@ -188,6 +205,23 @@ inline void write_into_place(value_collection data, llvm::Value*& target, bool s
 		uint64_t size = size_of_Value(single_object);
 		if (size == 0) continue;
 
+		if (!ssa && size >= bulk_copy_threshold)
+		{
+			llvm::Value* location = offset ? IRB->CreateConstInBoundsGEP1_64(target, offset, s("write")) : target;
+			if (llvm::Value* source = unchanged_source(single_object))
+			{
+				//two different stack objects can't overlap. anything else might be the same object, such as [store a a].
+				llvm::Value* source_object = source->stripInBoundsConstantOffsets();
+				llvm::Value* target_object = location->stripInBoundsConstantOffsets();
+				if (llvm::isa<llvm::AllocaInst>(source_object) && llvm::isa<llvm::AllocaInst>(target_object) && source_object != target_object)
+					IRB->CreateMemCpy(location, source, size * sizeof(uint64_t), alignof(uint64_t));
+				else IRB->CreateMemMove(location, source, size * sizeof(uint64_t), alignof(uint64_t));
+			}
+			else IRB->CreateStore(single_object, IRB->CreatePointerCast(location, single_object->getType()->getPointerTo()));
+			offset += size;
+			continue;
+		}
+
 		for (uint64_t subplace = 0; subplace < size; ++subplace)
 		{
 			llvm::Value* integer_transfer = (size > 1) ? IRB->CreateExtractValue(single_object, subplace) : single_object;
@@ -270,6 +304,7 @@ inline llvm::Value* load_from_memory(llvm::Value* location, uint64_t size)
 {
 	check(size < ~0u, "load object not equipped to deal with large objects, because CreateInsertValue has a small index");
 	if (size == 1) return IRB->CreateLoad(location);
+	if (size >= bulk_copy_threshold) return IRB->CreateLoad(IRB->CreatePointerCast(location, llvm_array(size)->getPointerTo()), s("bulk load"));
 	llvm::Value* undef_value = llvm::UndefValue::get(llvm_array(size));
 	for (uint64_t a = 0; a < size; ++a)
 	{
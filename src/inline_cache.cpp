@@ -0,0 +1,65 @@
+#include <iostream>
+#include <unordered_set>
+#include "inline_cache.h"
+#include "runtime.h"
+#include "utility.h"
+
+static std::unordered_set<dyn_subobj_cache*>& live_inline_caches()
+{
+	static never_destroyed<std::unordered_set<dyn_subobj_cache*>> caches;
+	return caches.get();
+}
+static uint64_t dead_cache_hits = 0;
+static uint64_t dead_cache_misses = 0;
+
+dyn_subobj_cache::dyn_subobj_cache(uAST* s) : site(s) { live_inline_caches().insert(this); }
+dyn_subobj_cache::~dyn_subobj_cache()
+{
+	dead_cache_hits += hits;
+	dead_cache_misses += misses;
+	live_inline_caches().erase(this);
+}
+
+std::array<uint64_t, 2> dyn_subobj_cache_miss(dyn_subobj_cache* cache, uint64_t type, uint64_t offset)
+{
+	++cache->misses;
+	std::array<uint64_t, 2> result = dynamic_subtype(type, offset);
+	record_feature(feature_kind::runtime, (uint64_t)runtime_feature::inline_cache_miss, feature_of_type(type), feature_of_type(result[0]));
+	if (type == 0) return result; //empty entries already have this answer at offset 0, and it's cheap anyway.
+	for (auto& e : cache->entries)
+	{
+		if (e.type == 0)
+		{
+			e.type = type;
+			e.offset = offset;
+			e.single_type = result[0];
+			e.switch_type = result[1];
+			break;
+		}
+	}
+	return result;
+}
+
+void flush_inline_caches()
+{
+	for (dyn_subobj_cache* cache : live_inline_caches()) cache->flush();
+}
+
+void print_inline_cache_stats(bool per_site)
+{
+	uint64_t hits = dead_cache_hits, misses = dead_cache_misses;
+	for (dyn_subobj_cache* cache : live_inline_caches())
+	{
+		hits += cache->hits;
+		misses += cache->misses;
+		if (per_site)
+		{
+			uint64_t filled = 0;
+			for (auto& e : cache->entries) filled += (e.type != 0);
+			std::cout << "dyn_subobj site " << cache->site << " hits " << cache->hits << " misses " << cache->misses << " types " << filled << '\n';
+		}
+	}
+	std::cout << "dyn_subobj inline cache hits " << hits << " misses " << misses;
+	if (hits + misses) std::cout << " hit rate " << (float)hits / (hits + misses);
+	std::cout << '\n';
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+struct uAST;
+
+/* inline caches for dyn_subobj. a dyn_subobj site that has to look up a dynamic type calls dynamic_subtype(), and nearly always sees the same type.
+so each such site gets a dyn_subobj_cache. generate_IR() emits a guard against each entry, and on a match, it loads the cached answer instead of calling.
+a miss calls dyn_subobj_cache_miss(), which fills an empty entry. once all entries are full, the site is megamorphic, and misses just call dynamic_subtype().
+types are GC'd, so a dead type's address could come back as a different type. start_GC() empties every cache.
+caches belong to the jit_module that holds the site's code, so they die with it.
+*/
+struct dyn_subobj_cache
+{
+	static constexpr uint64_t polymorphic_limit = 4;
+
+	//an empty entry is all zeroes, which is also the right answer for the 0 type at offset 0.
+	struct entry
+	{
+		uint64_t type = 0;
+		uint64_t offset = 0;
+		uint64_t single_type = 0; //what dynamic_subtype() returned
+		uint64_t switch_type = 0;
+	};
+	std::array<entry, polymorphic_limit> entries;
+	uint64_t hits = 0;
+	uint64_t misses = 0;
+	uAST* site; //only for identifying the site in statistics. it's never dereferenced.
+
+	dyn_subobj_cache(uAST* s);
+	~dyn_subobj_cache();
+	void flush() { entries.fill(entry()); }
+};
+
+std::array<uint64_t, 2> dyn_subobj_cache_miss(dyn_subobj_cache* cache, uint64_t type, uint64_t offset);
+void flush_inline_caches();
+void print_inline_cache_stats(bool per_site); //the totals include sites that have died.
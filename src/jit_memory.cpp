@@ -0,0 +1,165 @@
+#include <iostream>
+#include <algorithm>
+#include <llvm/Support/Process.h>
+#include "jit_memory.h"
+#include "globalinfo.h"
+
+jit_memory_pool jit_memory;
+
+jit_memory_pool::slab* jit_memory_pool::new_slab(uint64_t size, bool executable)
+{
+	std::error_code ec;
+	//code slabs aren't executable yet. finalizeMemory() flips each block once it's written.
+	unsigned flags = llvm::sys::Memory::MF_READ | llvm::sys::Memory::MF_WRITE;
+	llvm::sys::MemoryBlock mapping = llvm::sys::Memory::allocateMappedMemory(size, nullptr, flags, ec);
+	check(!ec && mapping.base(), "couldn't map a JIT slab");
+	slabs.emplace_back(new slab);
+	slab* s = slabs.back().get();
+	s->mapping = mapping;
+	s->executable = executable;
+	++slabs_mapped;
+	return s;
+}
+
+unsigned jit_memory_pool::page_class()
+{
+	static unsigned log2_page_size = [] { unsigned c = 0; while ((1ull << c) < llvm::sys::Process::getPageSize()) ++c; return c; }();
+	return log2_page_size;
+}
+
+uint64_t jit_memory_pool::block::reserved() const
+{
+	return size_class > largest_class ? owner->mapping.size() : 1ull << size_class;
+}
+
+//a reused code block was left read-execute by its last module, so it's made writable again.
+static void make_writable(const jit_memory_pool::block& b)
+{
+	if (!b.owner->executable) return;
+	std::error_code ec = llvm::sys::Memory::protectMappedMemory(llvm::sys::MemoryBlock(b.address, b.reserved()), llvm::sys::Memory::MF_READ | llvm::sys::Memory::MF_WRITE);
+	if (ec) error("couldn't make a JIT code block writable");
+}
+
+jit_memory_pool::block jit_memory_pool::allocate(uint64_t size, unsigned alignment, bool executable)
+{
+	if (alignment < 16) alignment = 16;
+	check((alignment & (alignment - 1)) == 0, "alignment must be a power of two");
+	if (executable && alignment < (1u << page_class())) alignment = 1u << page_class(); //code blocks don't share pages.
+	live_bytes[executable] += size;
+	total_bytes[executable] += size;
+
+	unsigned size_class = executable ? page_class() : smallest_class;
+	while (size_class <= largest_class && (1ull << size_class) < size) ++size_class;
+	if (size_class > largest_class) //too big for the size classes. it gets its own slab.
+	{
+		slab* s = new_slab(size, executable);
+		s->live_blocks = 1;
+		return {(uint8_t*)s->mapping.base(), size, size_class, s};
+	}
+
+	auto& list = free_lists[executable][size_class - smallest_class];
+	for (uint64_t x = list.size(); x-- > 0;) //newest first, since those are more likely to be in cache
+	{
+		if ((uintptr_t)list[x].address % alignment) continue;
+		block b = list[x];
+		list[x] = list.back();
+		list.pop_back();
+		b.size = size;
+		++b.owner->live_blocks;
+		++reused_blocks;
+		make_writable(b);
+		return b;
+	}
+
+	uint64_t class_size = 1ull << size_class;
+	slab* s = current[executable];
+	uint64_t offset = s ? (s->used + alignment - 1) & ~(uint64_t)(alignment - 1) : 0;
+	if (!s || offset + class_size > s->mapping.size())
+	{
+		s = current[executable] = new_slab(slab_size, executable);
+		offset = 0;
+	}
+	s->used = offset + class_size;
+	++s->live_blocks;
+	block b = {(uint8_t*)s->mapping.base() + offset, size, size_class, s};
+	if (offset < s->high_water) make_writable(b); //the slab was rewound, over blocks that might have been finalized.
+	s->high_water = std::max(s->high_water, s->used);
+	return b;
+}
+
+void jit_memory_pool::free(block b)
+{
+	live_bytes[b.owner->executable] -= b.size;
+	if (--b.owner->live_blocks == 0) release_slab(b.owner);
+	else free_lists[b.owner->executable][b.size_class - smallest_class].push_back(b);
+}
+
+void jit_memory_pool::release_slab(slab* s)
+{
+	for (auto& list : free_lists[s->executable])
+		list.erase(std::remove_if(list.begin(), list.end(), [s](const block& b) { return b.owner == s; }), list.end());
+
+	if (s == current[s->executable]) //keep the slab we're allocating from, but rewind it.
+	{
+		s->used = 0;
+		return;
+	}
+	llvm::sys::Memory::releaseMappedMemory(s->mapping);
+	auto position = std::find_if(slabs.begin(), slabs.end(), [s](const std::unique_ptr<slab>& x) { return x.get() == s; });
+	check(position != slabs.end(), "releasing a slab that isn't in the pool");
+	*position = std::move(slabs.back());
+	slabs.pop_back();
+}
+
+void jit_memory_pool::print_stats()
+{
+	std::cout << "jit code bytes " << total_bytes[1] << " live " << live_bytes[1] << '\n';
+	std::cout << "jit data bytes " << total_bytes[0] << " live " << live_bytes[0] << '\n';
+	if (modules_allocated) std::cout << "jit code bytes per module " << (float)total_bytes[1] / modules_allocated << '\n';
+	std::cout << "jit slabs mapped " << slabs_mapped << " live " << slabs.size() << " reused blocks " << reused_blocks << '\n';
+}
+
+jit_memory_pool::~jit_memory_pool()
+{
+	for (auto& s : slabs) llvm::sys::Memory::releaseMappedMemory(s->mapping);
+}
+
+uint8_t* pooled_memory_manager::allocateCodeSection(uintptr_t Size, unsigned Alignment, unsigned SectionID, llvm::StringRef SectionName)
+{
+	blocks.push_back(jit_memory.allocate(Size, Alignment, true));
+	if (usage)
+	{
+		usage->code_bytes += Size;
+		usage->code_sections.push_back({blocks.back().address, Size});
+	}
+	return blocks.back().address;
+}
+
+uint8_t* pooled_memory_manager::allocateDataSection(uintptr_t Size, unsigned Alignment, unsigned SectionID, llvm::StringRef SectionName, bool IsReadOnly)
+{
+	blocks.push_back(jit_memory.allocate(Size, Alignment, false));
+	if (usage) usage->data_bytes += Size;
+	return blocks.back().address;
+}
+
+//relocations are applied before this is called, so the code is done being written.
+bool pooled_memory_manager::finalizeMemory(std::string* ErrMsg)
+{
+	for (auto& b : blocks)
+	{
+		if (!b.owner->executable) continue;
+		std::error_code ec = llvm::sys::Memory::protectMappedMemory(llvm::sys::MemoryBlock(b.address, b.reserved()), llvm::sys::Memory::MF_READ | llvm::sys::Memory::MF_EXEC);
+		if (ec)
+		{
+			if (ErrMsg) *ErrMsg = ec.message();
+			return true;
+		}
+		llvm::sys::Memory::InvalidateInstructionCache(b.address, b.size);
+	}
+	return false; //false means success
+}
+
+pooled_memory_manager::~pooled_memory_manager()
+{
+	for (auto& b : blocks) jit_memory.free(b);
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <llvm/ExecutionEngine/RTDyldMemoryManager.h>
+#include <llvm/Support/Memory.h>
+
+/* JIT'd code and data are carved out of large slabs, instead of each module getting its own pages from a SectionMemoryManager.
+blocks are rounded up to a power-of-two size class. freed blocks go on a free list for their class, and later modules reuse them.
+a slab is unmapped once every block carved from it is freed. objects bigger than the largest class get their own slab.
+
+code and data come from separate slabs. code slabs are mapped read-write, and finalizing a module flips its code blocks to read-execute, so JIT'd code is never writable and executable at once.
+protection is per page, so code blocks are whole pages: the smallest code class is a page, and code blocks are page aligned.
+otherwise, finalizing one module would flip a page that another module is still writing or relocating into.
+a code block is flipped back to read-write when it's handed out again, from a free list or from below a slab's high water mark. memory above the mark has never been finalized, so it's still read-write, and a fresh block costs no mprotect.
+*/
+class jit_memory_pool
+{
+public:
+	static constexpr uint64_t slab_size = 1 << 20;
+	static constexpr unsigned smallest_class = 6; //64 bytes
+	static constexpr unsigned largest_class = 19; //half a slab
+	static unsigned page_class(); //log2 of the page size. the smallest class for code.
+
+	struct slab
+	{
+		llvm::sys::MemoryBlock mapping;
+		uint64_t used = 0; //bump pointer, as an offset from the start
+		uint64_t high_water = 0; //the furthest the bump pointer has been. rewinding the slab doesn't lower it.
+		uint64_t live_blocks = 0;
+		bool executable;
+	};
+	struct block
+	{
+		uint8_t* address;
+		uint64_t size; //requested size, for accounting
+		unsigned size_class; //larger than largest_class if the block has its own slab
+		slab* owner;
+		uint64_t reserved() const; //the whole pages or class the block owns, which is what gets protected.
+	};
+
+	block allocate(uint64_t size, unsigned alignment, bool executable);
+	void free(block b);
+	void print_stats();
+	~jit_memory_pool();
+
+	//statistics. index 0 is data, index 1 is code.
+	uint64_t live_bytes[2] = {0, 0};
+	uint64_t total_bytes[2] = {0, 0};
+	uint64_t reused_blocks = 0;
+	uint64_t slabs_mapped = 0;
+	uint64_t modules_allocated = 0;
+
+private:
+	slab* new_slab(uint64_t size, bool executable);
+	void release_slab(slab* s);
+
+	std::vector<std::unique_ptr<slab>> slabs;
+	slab* current[2] = {nullptr, nullptr}; //the slab we're bump allocating from, for data and for code
+	std::vector<block> free_lists[2][largest_class - smallest_class + 1];
+};
+extern jit_memory_pool jit_memory;
+
+//how much JIT memory a module holds. written by its memory manager when Orc links the module.
+struct jit_memory_usage
+{
+	uint64_t code_bytes = 0;
+	uint64_t data_bytes = 0;
+	std::vector<std::pair<uint8_t*, uint64_t>> code_sections; //start and size. for the perf map.
+};
+
+//one per module. Orc owns it, and destroys it when the module is removed, which returns the module's blocks to the pool.
+class pooled_memory_manager : public llvm::RTDyldMemoryManager
+{
+	std::vector<jit_memory_pool::block> blocks;
+	jit_memory_usage* usage; //can be nullptr
+public:
+	pooled_memory_manager(jit_memory_usage* u) : usage(u) { ++jit_memory.modules_allocated; }
+	uint8_t* allocateCodeSection(uintptr_t Size, unsigned Alignment, unsigned SectionID, llvm::StringRef SectionName) override;
+	uint8_t* allocateDataSection(uintptr_t Size, unsigned Alignment, unsigned SectionID, llvm::StringRef SectionName, bool IsReadOnly) override;
+	bool finalizeMemory(std::string* ErrMsg = nullptr) override;
+	~pooled_memory_manager();
+};
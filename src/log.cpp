@@ -0,0 +1,147 @@
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+#include "log.h"
+#include "utility.h"
+
+log_level LOG_LEVEL = log_level::info;
+
+namespace
+{
+//appends to a string, so formatting never touches a file.
+struct string_appender : std::streambuf
+{
+	std::string text;
+	int_type overflow(int_type c) override
+	{
+		if (c != traits_type::eof()) text.push_back((char)c);
+		return c;
+	}
+	std::streamsize xsputn(const char* s, std::streamsize n) override
+	{
+		text.append(s, n);
+		return n;
+	}
+};
+}
+
+struct thread_log
+{
+	std::recursive_mutex lock; //recursive, because error() flushes, and it can be called while this thread is formatting.
+	string_appender buffer;
+	std::ostream stream{&buffer};
+};
+
+static std::vector<thread_log*>& thread_logs()
+{
+	static never_destroyed<std::vector<thread_log*>> logs;
+	return logs.get();
+}
+static std::mutex& thread_logs_lock() //for registering a thread, and for walking the list.
+{
+	static never_destroyed<std::mutex> lock;
+	return lock.get();
+}
+static std::recursive_mutex& log_write_lock() //held from taking a buffer until it's written, so that a thread's chunks can't pass each other.
+{
+	static never_destroyed<std::recursive_mutex> lock;
+	return lock.get();
+}
+static std::condition_variable& log_chunk_ready()
+{
+	static never_destroyed<std::condition_variable> ready;
+	return ready.get();
+}
+static thread_local thread_log* this_thread_log = nullptr;
+
+//the caller holds log_write_lock. the spare string keeps its capacity, so a swap doesn't allocate.
+//if wait is false, a buffer that's being printed into is left for next time.
+static void write_thread_log(thread_log* log, bool wait)
+{
+	static never_destroyed<std::string> spare_string;
+	std::string* spare = &spare_string.get();
+	{
+		std::unique_lock<std::recursive_mutex> guard(log->lock, std::defer_lock);
+		if (wait) guard.lock();
+		else if (!guard.try_lock()) return;
+		if (log->buffer.text.empty()) return;
+		spare->swap(log->buffer.text);
+	}
+	fwrite(spare->data(), 1, spare->size(), stderr);
+	spare->clear();
+}
+
+static void write_thread_logs(bool wait)
+{
+	std::lock_guard<std::recursive_mutex> writing(log_write_lock());
+	std::lock_guard<std::mutex> guard(thread_logs_lock());
+	for (thread_log* log : thread_logs())
+		write_thread_log(log, wait);
+}
+
+void flush_log() { write_thread_logs(true); }
+
+//the background pass doesn't wait on a thread that's printing, so it can't deadlock with error() called from inside a print.
+static void log_flusher()
+{
+	std::mutex sleep_lock;
+	while (1)
+	{
+		{
+			std::unique_lock<std::mutex> sleeping(sleep_lock);
+			log_chunk_ready().wait_for(sleeping, std::chrono::milliseconds(log_flush_milliseconds));
+		}
+		write_thread_logs(false);
+	}
+}
+
+//the flusher is detached. exit() runs atexit handlers before other threads stop, so the final flush waits for any write in progress.
+static void start_log_flusher()
+{
+	std::thread(log_flusher).detach();
+	std::atexit(flush_log);
+}
+
+static thread_log& get_thread_log()
+{
+	if (this_thread_log == nullptr)
+	{
+		this_thread_log = new thread_log;
+		this_thread_log->buffer.text.reserve(log_chunk_size);
+		std::lock_guard<std::mutex> guard(thread_logs_lock());
+		thread_logs().push_back(this_thread_log);
+		static std::once_flag flusher_started;
+		std::call_once(flusher_started, start_log_flusher);
+	}
+	return *this_thread_log;
+}
+
+log_writer::log_writer() : log(get_thread_log()), stream(log.stream)
+{
+	log.lock.lock();
+}
+
+log_writer::~log_writer()
+{
+	uint64_t size = log.buffer.text.size();
+	log.lock.unlock();
+	if (size >= log_buffer_limit)
+	{
+		std::lock_guard<std::recursive_mutex> writing(log_write_lock());
+		write_thread_log(&log, true);
+	}
+	else if (size >= log_chunk_size) log_chunk_ready().notify_one();
+}
+
+uint64_t buffered_log_bytes()
+{
+	if (this_thread_log == nullptr) return 0;
+	std::lock_guard<std::recursive_mutex> guard(this_thread_log->lock);
+	return this_thread_log->buffer.text.size();
+}
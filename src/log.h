@@ -0,0 +1,30 @@
+#pragma once
+#include <cstdint>
+#include <ostream>
+
+/* buffered console output. std::cerr is unbuffered, so printing straight to it makes a write() per argument, and in the fuzzer that's most of the wall time.
+instead, print() formats into its thread's log buffer. a background thread writes the buffers to stderr every log_flush_milliseconds, or sooner when one passes log_chunk_size.
+a buffer is capped at log_buffer_limit bytes. past that, the printing thread writes its own buffer out, so a flood of output slows the program down instead of growing memory.
+one writer at a time, so a thread's output stays in order. different threads' output is interleaved by chunk, not by line.
+buffers are flushed at exit and by error(). anything that reads stdin should call flush_log() first, so that its prompt shows up.
+if the program crashes, up to log_flush_milliseconds of output is lost.
+with QUIET, print() returns before formatting anything, and with NO_CONSOLE it's empty.
+*/
+enum class log_level : uint64_t { debug, info, warning };
+extern log_level LOG_LEVEL; //messages below this level are dropped before they're formatted. "loglevel warning" keeps only warnings.
+constexpr uint64_t log_chunk_size = 1 << 12;
+constexpr uint64_t log_buffer_limit = 1 << 20;
+constexpr uint64_t log_flush_milliseconds = 10;
+
+struct thread_log;
+//holds this thread's buffer while one print() formats into it.
+struct log_writer
+{
+	thread_log& log;
+	std::ostream& stream;
+	log_writer();
+	~log_writer();
+};
+
+void flush_log(); //writes out every thread's buffer, and returns once it's written.
+uint64_t buffered_log_bytes(); //in this thread's buffer. for the test suite.
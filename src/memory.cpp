@@ -7,8 +7,13 @@
 #include "runtime.h"
 #include "function.h"
 #include "vector.h"
+#include "inline_cache.h"
+#include "profile.h"
+#include "perf_map.h"
+#include "trace.h"
 
 uint64_t free_memory_count = pool_size;
+uint64_t allocation_count = 0;
 
 //found_living_object and found_function depend on these pools being contiguous
 std::vector<uint64_t> big_memory_allocation(pool_size, initial_special_value);
@@ -46,6 +51,7 @@ uint64_t MEMORY_BEING_TRACED = false; //used to catch allocations while GC is ru
 uint64_t* allocate(uint64_t size)
 {
 	free_memory_count -= size;
+	++allocation_count;
 	check(size != 0, "allocating 0 elements means nothing");
 	check(!MEMORY_BEING_TRACED, "no allocating while GCing");
 	uint64_t true_size = size;
@@ -140,16 +146,24 @@ void initialize_roots()
 		if (VERBOSE_GC) print("gc root function at ", root_function, '\n');
 		mark_target((uint64_t&)root_function, Typen("function pointer"));
 	}
+	//a profiled AST has to stay printable as long as code counts it.
+	for (AST_counter* counter : live_AST_counters())
+		mark_target((uint64_t&)counter->site, u::AST_pointer);
 
 	//add in the event-driven ASTs
 }
 void trace_objects();
 
+std::vector<std::shared_ptr<jit_module>> retired_modules; //modules whose functions were reoptimized. they can't be removed until no JIT code is running.
 void start_GC()
 {
+	trace_span span("start_GC");
+	retired_modules.clear();
+	flush_inline_caches(); //the GC might free types that the caches hold.
 	UNSERIALIZATION_MODE = false;
 	free_memory_count = pool_size;
 	trace_objects();
+	if (PERF_MAP) perf_map_sync(); //the sweep removes modules, which retires their entries.
 }
 
 
@@ -192,14 +206,20 @@ void trace_objects()
 	sweep_function_pool_flags = new uint64_t[function_pool_size / 64]();
 	check(living_objects.empty(), "need to start GC with an empty tree");
 	type_hash_table.clear(); //clear the unique table, we'll rebuild it.
-	initialize_roots();
+	{
+		trace_span span("initialize_roots"); //this is the mark phase.
+		initialize_roots();
+	}
 	if (VERBOSE_GC)
 	{
 		for (auto& x : living_objects)
 			print("living object ", x.first, " size ", x.second, '\n');
 	}
 
-	sweepy_sweep();
+	{
+		trace_span span("sweepy_sweep");
+		sweepy_sweep();
+	}
 	delete[] sweep_function_pool_flags;
 
 	if (VERBOSE_GC)
@@ -355,7 +375,7 @@ void mark_target(uint64_t& memory, Tptr t)
 			if (found_function(func)) break;
 			mark_target((uint64_t&)(func->the_AST), u::AST_pointer);
 			mark_target((uint64_t&)(func->return_type), u::type);
-			//future: maybe the parameter
+			mark_target((uint64_t&)(func->parameter_type), u::type);
 		}
 		break;
 	}
@@ -405,6 +425,7 @@ void sweepy_sweep()
 	else check(memory_incrementor == &big_memory_pool[pool_size], "memory incrementor is past the pool");
 	living_objects.clear();
 
+	trace_span span("finalizers"); //destroying dead functions removes their modules.
 	for (uint64_t x = 0; x < function_pool_size / 64; ++x)
 	{
 		uint64_t diffmask = function_pool_flags[x] - sweep_function_pool_flags[x];
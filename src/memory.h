@@ -26,6 +26,7 @@ inline void correct_pointer(uint64_t*& memory) { if (memory != 0) memory += poin
 
 extern uint64_t* big_memory_pool;
 extern uint64_t free_memory_count;
+extern uint64_t allocation_count; //number of allocate() calls ever made. lets callers measure how much they allocate.
 
 
 void serialize(uint64_t id);
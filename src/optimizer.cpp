@@ -0,0 +1,284 @@
+#include <unordered_map>
+#include "optimizer.h"
+
+namespace
+{
+//these have no side effects and can't fail, and all their fields are integers.
+bool is_pure_arithmetic(uint64_t tag)
+{
+	switch (tag)
+	{
+	case ASTn("increment"):
+	case ASTn("decrement"):
+	case ASTn("add"):
+	case ASTn("subtract"):
+	case ASTn("multiply"):
+	case ASTn("lessu"):
+	case ASTn("lesss"):
+	case ASTn("udiv"):
+	case ASTn("urem"):
+	case ASTn("ushr"):
+	case ASTn("sshr"):
+	case ASTn("shl"):
+		return true;
+	default:
+		return false;
+	}
+}
+
+//must agree with what generate_IR() emits, including the division by zero and overlong shift cases.
+uint64_t fold_arithmetic(uint64_t tag, uint64_t a, uint64_t b)
+{
+	switch (tag)
+	{
+	case ASTn("increment"): return a + 1;
+	case ASTn("decrement"): return a - 1;
+	case ASTn("add"): return a + b;
+	case ASTn("subtract"): return a - b;
+	case ASTn("multiply"): return a * b;
+	case ASTn("lessu"): return a < b;
+	case ASTn("lesss"): return (int64_t)a < (int64_t)b;
+	case ASTn("udiv"): return b ? a / b : 0;
+	case ASTn("urem"): return b ? a % b : a;
+	case ASTn("ushr"): return b < 64 ? a >> b : 0;
+	case ASTn("sshr"): return b < 64 ? (uint64_t)((int64_t)a >> b) : 0;
+	case ASTn("shl"): return b < 64 ? a << b : 0;
+	default: error("not an arithmetic AST");
+	}
+}
+
+bool is_integer_imv(uAST* t)
+{
+	if (t->tag != ASTn("imv") || t->fields[0] == nullptr) return false;
+	Tptr type = ((dynobj*)t->fields[0])->type;
+	return type != 0 && type.ver() == Typen("integer");
+}
+
+class AST_optimizer
+{
+	const AST_type_record& types;
+	llvm::DenseMap<uAST*, uint64_t> references; //how many AST fields refer to each AST. the root counts as one reference.
+	llvm::SmallPtrSet<uAST*, 16> non_arithmetic_uses; //ASTs that something other than arithmetic refers to. these might be written to or placed on the stack, so they can't be shared.
+	llvm::DenseMap<uAST*, std::pair<bool, uint64_t>> constants; //whether an AST folds to a constant, and what the constant is.
+	llvm::DenseMap<uAST*, uAST*> copies; //maps input ASTs to output ASTs
+	std::unordered_map<uint64_t, uAST*> shared_constants; //DenseMap reserves two keys, and those are valid integers.
+
+	void count_references(uAST* root)
+	{
+		llvm::SmallPtrSet<uAST*, 32> seen;
+		llvm::SmallVector<uAST*, 32> worklist{root};
+		++references[root];
+		non_arithmetic_uses.insert(root);
+		seen.insert(root);
+		while (!worklist.empty())
+		{
+			uAST* t = worklist.pop_back_val();
+			for (uAST*& field : AST_range(t))
+			{
+				if (field == nullptr) continue;
+				++references[field];
+				if (!is_pure_arithmetic(t->tag)) non_arithmetic_uses.insert(field);
+				if (seen.insert(field).second) worklist.push_back(field);
+			}
+		}
+	}
+
+	//true if every reference into these subtrees comes from inside them, or from the one field that holds each root.
+	//then, dropping them can't break a reference, a pointer, or a goto elsewhere.
+	//a parameter is never dropped, even if it's unreachable, because that would change the function's parameter type.
+	bool exclusively_owned(llvm::ArrayRef<uAST*> roots)
+	{
+		llvm::DenseMap<uAST*, uint64_t> internal;
+		llvm::SmallVector<uAST*, 16> worklist;
+		for (uAST* root : roots)
+			if (root && ++internal[root] == 1) worklist.push_back(root);
+		while (!worklist.empty())
+		{
+			uAST* t = worklist.pop_back_val();
+			if (t->tag == ASTn("parameter")) return false;
+			for (uAST*& field : AST_range(t))
+				if (field && ++internal[field] == 1) worklist.push_back(field);
+		}
+		for (auto& k : internal)
+			if (k.second != references.lookup(k.first)) return false;
+		return true;
+	}
+
+	bool constant_value(uAST* t, uint64_t& value)
+	{
+		if (t == nullptr) return false;
+		auto found = constants.find(t);
+		if (found != constants.end())
+		{
+			value = found->second.second;
+			return found->second.first;
+		}
+
+		bool known = false;
+		value = 0;
+		if (is_integer_imv(t))
+		{
+			known = true;
+			value = (*(dynobj*)t->fields[0])[0];
+		}
+		else if (t->tag == ASTn("zero")) known = true;
+		else if (is_pure_arithmetic(t->tag))
+		{
+			uint64_t operand[2] = {0, 0};
+			uint64_t number_of_operands = AST_descriptor[t->tag].pointer_fields;
+			known = true;
+			for (uint64_t x = 0; x < number_of_operands; ++x)
+				known = known && constant_value(t->fields[x], operand[x]);
+			//folding drops the operands, so nothing else can be relying on them having run.
+			known = known && exclusively_owned(llvm::ArrayRef<uAST*>(&t->fields[0], number_of_operands));
+			if (known) value = fold_arithmetic(t->tag, operand[0], operand[1]);
+		}
+		constants.insert({t, {known, value}});
+		return known;
+	}
+
+	uAST* new_constant(uAST* t, uint64_t value)
+	{
+		bool shareable = !non_arithmetic_uses.count(t);
+		if (shareable)
+		{
+			auto found = shared_constants.find(value);
+			if (found != shared_constants.end()) return found->second;
+		}
+		dynobj* object = new_dynamic_obj(u::integer);
+		(*object)[0] = value;
+		uAST* result = new_AST(ASTn("imv"), (uAST*)object);
+		if (shareable) shared_constants.insert({value, result});
+		return result;
+	}
+
+	bool same_type(Tptr a, Tptr b)
+	{
+		return type_check(RVO, a, b) == type_check_result::perfect_fit && type_check(RVO, b, a) == type_check_result::perfect_fit;
+	}
+
+	//if the condition is constant, the if can be replaced by the branch it takes. returns that branch, or nullptr.
+	uAST* taken_branch(uAST* t)
+	{
+		//the if's result is a copy of the branch's result. if something refers to the if, say to store into it, the branch can't stand in for it.
+		if (references.lookup(t) != 1) return nullptr;
+		uint64_t condition;
+		if (!constant_value(t->fields[0], condition)) return nullptr;
+		uint64_t taken = condition ? 1 : 2;
+		uAST* branch = t->fields[taken];
+		if (branch == nullptr || references.lookup(branch) != 1) return nullptr;
+
+		//the if's type combines both branches, so it can differ from the taken branch's type.
+		Tptr if_type(0), branch_type(0);
+		if (!types.find(t, if_type) || !types.find(branch, branch_type) || !same_type(if_type, branch_type)) return nullptr;
+
+		if (!exclusively_owned({t->fields[0], t->fields[3 - taken]})) return nullptr;
+		//the if clears the stack after each branch, so a later reference to an AST inside the branch evaluates it again. once the branch is in the basic block, the reference would reuse its value instead.
+		if (!exclusively_owned({branch})) return nullptr;
+		return branch;
+	}
+
+	//collects the elements of a basic block, flattening nested basic blocks, and dropping the code after a forward goto.
+	void collect_elements(uAST* BB, llvm::SmallVectorImpl<uAST*>& elements)
+	{
+		svector* k = (svector*)BB->fields[0];
+		uint64_t size = k->size;
+		for (uint64_t x = 0; x < size; ++x)
+		{
+			uAST* element = (uAST*)(*k)[x];
+			bool is_last = (x + 1 == size);
+			if (element && element->tag == ASTn("basicblock") && references.lookup(element) == 1
+				&& !(is_last && ((svector*)element->fields[0])->size == 0)) //an empty block at the end is the return value, so it stays.
+				collect_elements(element, elements);
+			else elements.push_back(element);
+
+			//a forward goto has type does_not_return. the elements after it are emitted into an unreachable block.
+			Tptr type(0);
+			if (element && !is_last && types.find(element, type) && type == u::does_not_return)
+			{
+				//the last element is the block's return value. it can only go if it has no type, because then the goto's empty return is the same.
+				uAST* last = (uAST*)(*k)[size - 1];
+				Tptr last_type = u::null;
+				bool drop_last = last == nullptr || (types.find(last, last_type) && last_type == u::null);
+				uint64_t end = drop_last ? size : size - 1;
+				llvm::ArrayRef<uAST*> unreachable((uAST**)&(*k)[x + 1], end - (x + 1));
+				if (exclusively_owned(unreachable))
+				{
+					if (!drop_last) elements.push_back(last);
+					return;
+				}
+			}
+		}
+	}
+
+	uAST* optimize(uAST* t)
+	{
+		if (t == nullptr) return nullptr;
+		auto found = copies.find(t);
+		if (found != copies.end()) return found->second;
+
+		uint64_t value;
+		bool is_constant_leaf = is_integer_imv(t) || t->tag == ASTn("zero");
+		if ((is_pure_arithmetic(t->tag) || (is_constant_leaf && !non_arithmetic_uses.count(t))) && constant_value(t, value))
+		{
+			uAST* folded = new_constant(t, value);
+			copies.insert({t, folded});
+			return folded;
+		}
+
+		if (t->tag == ASTn("if"))
+		{
+			if (uAST* branch = taken_branch(t))
+			{
+				//nothing can refer back to the if from inside the branch: that would have failed validation as an infinite loop, or a pointer without a target.
+				uAST* result = optimize(branch);
+				copies.insert({t, result});
+				return result;
+			}
+		}
+
+		if (t->tag == ASTn("basicblock"))
+		{
+			llvm::SmallVector<uAST*, 16> elements;
+			collect_elements(t, elements);
+			uAST* copy = new_AST(ASTn("basicblock"), elements);
+			copies.insert({t, copy});
+			svector* k = (svector*)copy->fields[0];
+			for (uint64_t x = 0; x < k->size; ++x)
+				(*k)[x] = (uint64_t)optimize((uAST*)(*k)[x]);
+			return copy;
+		}
+
+		//same as deep_AST_copier. the copy goes in the map before the fields are copied, because labels and gotos make cycles.
+		uAST* copy = copy_AST(t);
+		copies.insert({t, copy});
+		for (uint64_t x = 0; x < AST_descriptor[t->tag].pointer_fields; ++x)
+			copy->fields[x] = optimize(t->fields[x]);
+		return copy;
+	}
+
+public:
+	uAST* result;
+	AST_optimizer(uAST* target, const AST_type_record& t) : types(t)
+	{
+		count_references(target);
+		result = optimize(target);
+	}
+};
+}
+
+uAST* optimize_validated_AST(uAST* target, const AST_type_record& types)
+{
+	if (target == nullptr) return nullptr;
+	return AST_optimizer(target, types).result;
+}
+
+uAST* optimize_AST(uAST* target)
+{
+	if (target == nullptr) return nullptr;
+	AST_type_record types;
+	AST_validator validator;
+	validator.types = &types;
+	if (validator.validate(target).error_code) return target;
+	return optimize_validated_AST(target, types);
+}
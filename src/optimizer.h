@@ -0,0 +1,20 @@
+#pragma once
+#include "ASTs.h"
+#include "validator.h"
+
+/* the AST optimizer rewrites an AST DAG into a smaller one that compiles to the same function. it runs before generate_IR(), so LLVM sees less IR.
+the input is never modified. the output is a fresh copy, like deep_AST_copier makes, with these rewrites:
+	arithmetic on constants is folded into an imv.
+	an if with a constant condition becomes the branch that's taken.
+	basic blocks nested directly in basic blocks are flattened.
+	code after a forward goto in a basic block is dropped, since it's never reached.
+	integer constants that are only used by arithmetic are shared, so equal constants become one AST.
+
+ASTs are referenced by identity: a later occurrence of an AST is a reference to the earlier one, and pointer/goto name ASTs without compiling them.
+so a subtree is only ever dropped if nothing outside it refers into it. otherwise, the rewrite isn't done.
+the types come from validating the input. the rewrites must keep every type, which "crosscheck" mode checks.
+*/
+uAST* optimize_validated_AST(uAST* target, const AST_type_record& types);
+
+//validates the AST first. if it doesn't validate, the AST is returned unchanged, so that its errors stay the same. this is the "optimize" AST.
+uAST* optimize_AST(uAST* target);
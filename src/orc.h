@@ -10,6 +10,12 @@
 #include "llvm/IR/Module.h"
 #include "llvm/Support/TargetSelect.h"
 #include "globalinfo.h"
+#include "jit_memory.h"
+#include "inline_cache.h"
+#include "profile.h"
+#include "perf_map.h"
+#include "trace.h"
+#include <deque>
 
 //taken directly from Lang Hames' Orc Kaleidoscope tutorial
 
@@ -53,11 +59,12 @@ public:
 		return MangledName;
 	}
 
-	ModuleHandleT addModule(std::unique_ptr<llvm::Module> M)
+	//usage, if nonzero, is filled in with the module's JIT memory when Orc links it, which happens on the first symbol lookup.
+	ModuleHandleT addModule(std::unique_ptr<llvm::Module> M, jit_memory_usage* usage = nullptr)
 	{
 		//later, if we want optimization, we'll need to change this back
 		std::unique_ptr<llvm::orc::NullResolver> Resolver((new llvm::orc::NullResolver()));
-		return CompileLayer.addModuleSet(singletonSet(std::move(M)), llvm::make_unique<llvm::SectionMemoryManager>(), std::move(Resolver));
+		return CompileLayer.addModuleSet(singletonSet(std::move(M)), llvm::make_unique<pooled_memory_manager>(usage), std::move(Resolver));
 	}
 
 	void removeModule(ModuleHandleT H) { CompileLayer.removeModuleSet(H); }
@@ -71,3 +78,37 @@ private:
 	ObjLayerT ObjectLayer;
 	CompileLayerT CompileLayer;
 };
+
+extern KaleidoscopeJIT* c;
+extern llvm::TargetMachine* TM;
+
+//a module and its context. usually one function owns it, but a compile batch shares one module between many functions, so that they all go through a single Orc add.
+//functions hold it by shared_ptr. when the GC kills the last function using it, the module is removed from Orc.
+struct jit_module
+{
+	std::unique_ptr<llvm::LLVMContext> context;
+	std::unique_ptr<llvm::Module> pending; //nonzero until the module is added to Orc. must be below context, so that it's destroyed first.
+	KaleidoscopeJIT::ModuleHandleT handle;
+	bool added = false;
+	jit_memory_usage usage;
+	uint64_t codegen_level = 0; //llvm::CodeGenOpt::Level
+	std::vector<std::unique_ptr<dyn_subobj_cache>> inline_caches; //the module's code points into these, so they're destroyed after remove().
+	std::deque<AST_counter> AST_counters; //same as inline_caches. a deque, so that adding counters doesn't move the old ones.
+
+	jit_module() : context(new llvm::LLVMContext()), pending(new llvm::Module(GenerateUniqueName("jit_module_"), *context)) {}
+	void add()
+	{
+		if (VERBOSE_DEBUG) print("adding module...\n");
+		trace_span span("addModule"); //includes codegen.
+		TM->setOptLevel((llvm::CodeGenOpt::Level)codegen_level); //IRCompileLayer codegens immediately, so this only affects this module.
+		handle = c->addModule(std::move(pending), &usage);
+		added = true;
+	}
+	void remove()
+	{
+		if (added) c->removeModule(handle);
+		if (added && PERF_MAP) perf_map_retire(this);
+		added = false;
+	}
+	~jit_module() { remove(); }
+};
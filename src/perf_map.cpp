@@ -0,0 +1,121 @@
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <unordered_map>
+#include <sstream>
+#include <unistd.h>
+#include <llvm/ADT/DenseMap.h>
+#include "perf_map.h"
+#include "jit_memory.h"
+#include "ASTs.h"
+#include "types.h"
+#include "utility.h"
+
+//ASTs are a DAG, with cycles through labels and gotos. an AST that was already seen hashes as its position in the walk, so sharing is part of the structure.
+static uint64_t structural_hash_of(uAST* target, llvm::DenseMap<uAST*, uint64_t>& seen)
+{
+	if (target == nullptr) return 0;
+	auto found = seen.find(target);
+	if (found != seen.end()) return hash_combine(~0ull, found->second);
+	uint64_t position = seen.size();
+	seen.insert({target, position});
+
+	uint64_t h = hash_combine(fnv_offset_basis, target->tag);
+	for (uAST*& field : AST_range(target)) h = hash_combine(h, structural_hash_of(field, seen));
+	//an imv's object can hold pointers, which change between runs. integers are the common case, so only they're hashed.
+	if (target->tag == ASTn("imv") && target->fields[0])
+	{
+		dynobj* object = (dynobj*)target->fields[0];
+		if (object->type == u::integer) h = hash_combine(h, (*object)[0]);
+	}
+	return h;
+}
+
+uint64_t structural_hash(uAST* target)
+{
+	llvm::DenseMap<uAST*, uint64_t> seen;
+	return structural_hash_of(target, seen);
+}
+
+std::string perf_map_name(uAST* target)
+{
+	std::ostringstream name;
+	name << "AST_" << (target ? AST_descriptor[target->tag].name : "null") << '_' << std::hex << std::setw(16) << std::setfill('0') << structural_hash(target);
+	return name.str();
+}
+
+namespace
+{
+struct perf_map_entry
+{
+	const void* owner;
+	uint64_t section_end;
+	std::string name;
+};
+}
+
+static std::map<uint64_t, perf_map_entry>& perf_map_entries()
+{
+	static never_destroyed<std::map<uint64_t, perf_map_entry>> entries;
+	return entries.get();
+}
+static std::unordered_multimap<const void*, uint64_t>& perf_map_owners() //so that retiring a module doesn't look through every entry.
+{
+	static never_destroyed<std::unordered_multimap<const void*, uint64_t>> owners;
+	return owners.get();
+}
+static std::ofstream* perf_map_file = nullptr;
+static bool perf_map_stale = false; //the file has entries that were retired, or that overlap a newer entry.
+
+static void write_perf_map_line(std::map<uint64_t, perf_map_entry>::iterator k)
+{
+	auto next = std::next(k);
+	uint64_t end = k->second.section_end;
+	if (next != perf_map_entries().end() && next->first < end) end = next->first;
+	*perf_map_file << std::hex << k->first << ' ' << end - k->first << ' ' << k->second.name << '\n';
+}
+
+static void rewrite_perf_map()
+{
+	delete perf_map_file;
+	perf_map_file = new std::ofstream("/tmp/perf-" + std::to_string(getpid()) + ".map", std::ofstream::trunc);
+	for (auto k = perf_map_entries().begin(); k != perf_map_entries().end(); ++k) write_perf_map_line(k);
+	perf_map_file->flush();
+	perf_map_stale = false;
+}
+
+void perf_map_add(const void* owner, const void* address, const jit_memory_usage& usage, const std::string& name)
+{
+	uint64_t start = (uint64_t)address;
+	uint64_t section_end = start + 1; //if the address isn't in a code section, which shouldn't happen, the entry still marks it.
+	for (auto& section : usage.code_sections)
+		if ((uint64_t)section.first <= start && start < (uint64_t)section.first + section.second) section_end = (uint64_t)section.first + section.second;
+	auto k = perf_map_entries().insert({start, {owner, section_end, name}}).first;
+	perf_map_owners().insert({owner, start});
+
+	//an earlier line that ran past this address has to be cut short.
+	if (k != perf_map_entries().begin() && std::prev(k)->second.section_end > start) perf_map_stale = true;
+	if (perf_map_file == nullptr || perf_map_stale) rewrite_perf_map();
+	else
+	{
+		write_perf_map_line(k);
+		perf_map_file->flush(); //the event loop never exits, so perf may read the file while we're still running.
+	}
+}
+
+void perf_map_retire(const void* owner)
+{
+	auto range = perf_map_owners().equal_range(owner);
+	for (auto k = range.first; k != range.second; ++k)
+	{
+		auto entry = perf_map_entries().find(k->second);
+		if (entry != perf_map_entries().end() && entry->second.owner == owner) perf_map_entries().erase(entry);
+		perf_map_stale = true;
+	}
+	perf_map_owners().erase(range.first, range.second);
+}
+
+void perf_map_sync()
+{
+	if (perf_map_stale) rewrite_perf_map();
+}
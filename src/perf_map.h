@@ -0,0 +1,18 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+struct uAST;
+struct jit_memory_usage;
+
+/* /tmp/perf-<pid>.map, for the "perfmap" flag. perf reads it to name JIT'd code. each line is the start address and size in hex, then the name.
+a function is named after its AST's root tag and structural hash, so the same AST gets the same name in every run, and perf reports from different runs line up.
+sizes come from the module's code sections: a function runs until the next entry, or the end of its section.
+JIT memory is reused once a module is removed, so removing a module also removes its entries. the format has no way to remove a line, so the file is rewritten.
+*/
+uint64_t structural_hash(uAST* target); //doesn't depend on where the ASTs are in memory.
+std::string perf_map_name(uAST* target);
+//owner is whatever will retire the entry, usually the jit_module. usage must already have the module's code sections, so the module must have been linked.
+void perf_map_add(const void* owner, const void* address, const jit_memory_usage& usage, const std::string& name);
+void perf_map_retire(const void* owner);
+void perf_map_sync(); //rewrites the file, if entries were retired since it was last written. start_GC() calls this, since that's when most modules die.
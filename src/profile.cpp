@@ -0,0 +1,47 @@
+#include <algorithm>
+#include <array>
+#include <unordered_map>
+#include <vector>
+#include "profile.h"
+#include "debugoutput.h"
+#include "utility.h"
+
+std::unordered_set<AST_counter*>& live_AST_counters()
+{
+	static never_destroyed<std::unordered_set<AST_counter*>> counters;
+	return counters.get();
+}
+static std::array<uint64_t, ASTn("never reached")> dead_counts_by_tag;
+
+AST_counter::AST_counter(uAST* s) : site(s), tag(s->tag) { live_AST_counters().insert(this); }
+AST_counter::~AST_counter()
+{
+	dead_counts_by_tag[tag] += count;
+	live_AST_counters().erase(this);
+}
+
+void print_AST_profile()
+{
+	constexpr uint64_t hottest_shown = 20;
+	std::array<uint64_t, ASTn("never reached")> counts_by_tag = dead_counts_by_tag;
+	std::unordered_map<uAST*, uint64_t> counts_by_site;
+	for (AST_counter* counter : live_AST_counters())
+	{
+		counts_by_tag[counter->tag] += counter->count;
+		if (counter->count) counts_by_site[counter->site] += counter->count;
+	}
+
+	std::cout << "AST runs by tag\n";
+	for (uint64_t x = 0; x < ASTn("never reached"); ++x)
+		if (counts_by_tag[x]) std::cout << "tag " << x << ' ' << AST_descriptor[x].name << ' ' << counts_by_tag[x] << '\n';
+
+	std::vector<std::pair<uAST*, uint64_t>> hottest(counts_by_site.begin(), counts_by_site.end());
+	std::sort(hottest.begin(), hottest.end(), [](const std::pair<uAST*, uint64_t>& a, const std::pair<uAST*, uint64_t>& b) { return a.second > b.second; });
+	if (hottest.size() > hottest_shown) hottest.resize(hottest_shown);
+	print("hottest ASTs\n");
+	for (auto& k : hottest)
+	{
+		print(k.second, " runs: ");
+		output_AST_console_version(k.first);
+	}
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <cstdint>
+#include <unordered_set>
+
+struct uAST;
+
+/* execution counts for the "profile" flag. while PROFILE_ASTS is on, generate_IR() gives each AST it compiles an AST_counter, and emits an increment of the counter where the AST's code starts.
+so a count is how many times the AST ran. an AST compiled into several functions, say by inlining, has several counters, which are added together when printing.
+counters belong to the jit_module that holds their code, like inline caches. while a counter lives, the GC keeps its AST alive, so that it can still be printed.
+with the flag off, nothing is emitted, and the compiled code is the same as before profiling existed.
+*/
+struct AST_counter
+{
+	uAST* site;
+	uint64_t tag; //kept, so that counters can add to the per-tag totals when they die.
+	uint64_t count = 0;
+
+	AST_counter(uAST* s);
+	~AST_counter();
+	AST_counter(const AST_counter&) = delete; //JIT code points to it.
+};
+
+std::unordered_set<AST_counter*>& live_AST_counters(); //the GC marks their sites.
+void print_AST_profile(); //the totals for each tag, including dead counters, then the hottest living ASTs, in console format.
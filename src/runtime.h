@@ -3,6 +3,7 @@
 #include "cs11.h"
 #include "function.h"
 #include "memory.h"
+#include "coverage.h"
 
 //warning: array<uint64_t, 2> becomes {i64, i64}
 //using our current set of optimization passes, the undef+insertvalue operations aren't optimized to anything better.
@@ -30,26 +31,76 @@ inline uint64_t generate_exponential_dist()
 
 //if there isn't a preallocated location, then pass in nullptr for the second argument.
 //this copies the AST if and only if the second argument is nullptr
-inline function* compile_specifying_location(uAST* target, function* pre_allocated_location)
+//if batch is nonzero, the function goes into the batch's module, and its fptr is filled in by compile_batch::finish().
+inline function* compile_specifying_location(uAST* target, function* pre_allocated_location, std::shared_ptr<jit_module> batch = nullptr, uint64_t optimization_level = OPTIMIZATION_LEVEL)
 {
 
-	compiler_object a;
+	compiler_object a(std::move(batch), optimization_level);
 	uint64_t error = a.compile_AST(target);
 	if (error) return 0;
 	else
 	{
-		pre_allocated_location = new(pre_allocated_location ? pre_allocated_location : allocate_function()) function(pre_allocated_location ? target : deep_AST_copier(target).result, a.return_type, a.parameter_type, a.fptr, a.result_module, std::move(a.new_context));
+		pre_allocated_location = new(pre_allocated_location ? pre_allocated_location : allocate_function()) function(pre_allocated_location ? target : deep_AST_copier(target).result, a.return_type, a.parameter_type, a.fptr, std::move(a.module), a.symbol_name, optimization_level);
 
 		if (VERBOSE_GC) print(*pre_allocated_location);
 		return pre_allocated_location;
 	}
 }
 
+//compiles many ASTs into a single module, so that the per-module costs (codegen setup, section allocation, EH frame registration) are paid once.
+//the module is removed once every function in it has been GC'd.
+//the functions can't be run until finish() is called.
+class compile_batch
+{
+	std::shared_ptr<jit_module> module;
+	std::vector<function*> members;
+public:
+	compile_batch() : module(std::make_shared<jit_module>()) {}
+	function* compile_specifying_location(uAST* target, function* pre_allocated_location)
+	{
+		function* result = ::compile_specifying_location(target, pre_allocated_location, module);
+		if (result) members.push_back(result);
+		return result;
+	}
+
+	//one Orc add for the whole batch. in LAZY_COMPILE mode, this is left to the first run of any member.
+	void finish()
+	{
+		if (members.empty()) return;
+		if (DONT_ADD_MODULE_TO_ORC)
+		{
+			for (auto& f : members) f->fptr = (void*)2222222ull;
+		}
+		else if (!LAZY_COMPILE || DELETE_MODULE_IMMEDIATELY)
+		{
+			for (auto& f : members) f->materialize();
+			if (DELETE_MODULE_IMMEDIATELY) module->remove();
+		}
+		members.clear();
+	}
+};
+
 inline function* compile_returning_just_function(uAST* target)
 {
 	return compile_specifying_location(target, nullptr);
 }
 
+extern std::vector<std::shared_ptr<jit_module>> retired_modules;
+//recompiles a hot function at level 2, and swaps in the new fptr.
+//the old code might still be running further up the stack, so its module is retired instead of removed. start_GC() frees retired modules, since it only runs when no JIT code is on the stack.
+inline void reoptimize(function* func)
+{
+	func->optimization_level = 2; //even if recompilation fails, don't try again.
+	compiler_object a(nullptr, 2);
+	if (a.compile_AST(func->the_AST)) return;
+	if (a.return_type != func->return_type || a.parameter_type != func->parameter_type) return; //the AST was changed after the first compile, so the old fptr is kept.
+	if (VERBOSE_DEBUG) print("reoptimized ", func->symbol_name, " into ", a.symbol_name, '\n');
+	retired_modules.push_back(std::move(func->module));
+	func->module = std::move(a.module);
+	func->symbol_name = a.symbol_name;
+	func->fptr = a.fptr;
+}
+
 inline void output_array(uint64_t* mem, uint64_t number)
 {
 	for (uint64_t idx = 0; idx < number; ++idx)
@@ -65,36 +116,51 @@ template<size_t array_num> inline void cout_array(std::array<uint64_t, array_num
 }
 #include "dynamic.h"
 
-//return value is a dynamic object to the return value. it's just the object pointer, not the type.
-//on failure, we can't get the type. since this requires a branch, we should get the type here.
-inline dynobj* run_null_parameter_function(function* func)
+//wraps a single-word return value, for run_function.
+inline dynobj* box_return_value(Tptr type, uint64_t value)
 {
-	if (func == 0) return 0;
-	if (finiteness == 0) return 0;
-	else --finiteness;
+	return (dynobj*)new_object_value((uint64_t)type, value);
+}
+
+//calls fptr with one i64 argument per parameter word, which is how compile_AST() lays out parameters.
+template<typename return_type> inline return_type call_with_arguments(void* fptr, const uint64_t* a, uint64_t number_of_arguments)
+{
+	using u64 = uint64_t;
+	switch (number_of_arguments)
+	{
+	case 0: return ((return_type(*)())fptr)();
+	case 1: return ((return_type(*)(u64))fptr)(a[0]);
+	case 2: return ((return_type(*)(u64, u64))fptr)(a[0], a[1]);
+	case 3: return ((return_type(*)(u64, u64, u64))fptr)(a[0], a[1], a[2]);
+	case 4: return ((return_type(*)(u64, u64, u64, u64))fptr)(a[0], a[1], a[2], a[3]);
+	case 5: return ((return_type(*)(u64, u64, u64, u64, u64))fptr)(a[0], a[1], a[2], a[3], a[4]);
+	case 6: return ((return_type(*)(u64, u64, u64, u64, u64, u64))fptr)(a[0], a[1], a[2], a[3], a[4], a[5]);
+	default: error("more arguments than max_parameter_words");
+	}
+}
+static_assert(max_parameter_words == 6, "call_with_arguments() needs a case for each argument count");
+
+//the typed call: runs the function and writes its return value into the caller's buffer, which must hold get_size(func->return_type) words.
+//returns the return type, so that nothing has to be allocated to carry it. returns 0 if the function didn't run.
+//a function that returns a dynamic object still writes just the object pointer.
+//arguments must hold get_size(func->parameter_type) words. if the function has parameters and there are no arguments, it doesn't run.
+inline Tptr run_function_into(function* func, uint64_t* buffer, const uint64_t* arguments = nullptr)
+{
+	trace_span span("run_function");
+	if (func == 0) { record_feature(feature_kind::runtime, (uint64_t)runtime_feature::run_without_function); return 0; }
+	uint64_t number_of_arguments = get_size(func->parameter_type);
+	if (number_of_arguments && arguments == nullptr) { record_feature(feature_kind::runtime, (uint64_t)runtime_feature::run_without_arguments); return 0; }
+	if (finiteness == 0 && refill_finiteness() == 0) { record_feature(feature_kind::runtime, (uint64_t)runtime_feature::run_out_of_finiteness); return 0; }
+	--finiteness;
+	record_feature(feature_kind::runtime, (uint64_t)runtime_feature::run_function, feature_of_type(func->return_type), number_of_arguments);
+	if (HOT_THRESHOLD && func->optimization_level < 2 && ++func->run_count >= HOT_THRESHOLD) reoptimize(func);
+	if (func->fptr == nullptr) func->materialize(); //first run of a lazily compiled function
 	void* fptr = func->fptr;
 	Tptr return_type = func->return_type;
-	if (return_type == u::dynamic_object) return ((dynobj*(*)())fptr)(); //special case: if it already returns a dynamic object, don't wrap it again.
 	uint64_t size_of_return = get_size(return_type);
 	//print("return type of run function is: "); output_type(return_type); print('\n');
-	if (size_of_return == 1)
-	{
-		uint64_t(*FP)() = (uint64_t(*)())fptr;
-		return (dynobj*)new_object_value((uint64_t)return_type, FP());
-	}
-	else if (size_of_return == 0)
-	{
-		void(*FP)() = (void(*)())fptr;
-		FP();
-		return 0;
-	}
-/*	else if (size_of_return >= 4) //probably is so rare, not even worth making a case for.
-	{
-		auto FP = ((uint64_t*)(*)(uint64_t*))(void*)fptr;
-		uint64_t* k = FP(new uint64_t[size_of_return]);
-		output_array(&k[0], size_of_return);
-		return std::array < uint64_t, 2 > {{(uint64_t)return_type, (uint64_t)k}};
-	}*/
+	if (size_of_return == 1) buffer[0] = call_with_arguments<uint64_t>(fptr, arguments, number_of_arguments);
+	else if (size_of_return == 0) call_with_arguments<void>(fptr, arguments, number_of_arguments);
 	else //make a trampoline. this is definitely a bad solution, but too bad for us. later, we'll want a persistent trampoline that we can reuse and pass in function pointers to.
 	{
 		llvm::LLVMContext mini_context;
@@ -102,7 +168,7 @@ inline dynobj* run_null_parameter_function(function* func)
 		std::unique_ptr<llvm::Module> M(new llvm::Module(GenerateUniqueName("jit_module_"), mini_context));
 		builder_context_stack b(&new_builder, &mini_context); //for safety
 		using namespace llvm;
-		FunctionType *func_type(FunctionType::get(llvm_i64(), false));
+		FunctionType *func_type(FunctionType::get(llvm_void(), {llvm_i64()->getPointerTo(), llvm_i64()->getPointerTo()}, false));
 
 		std::string function_name = GenerateUniqueName("");
 		Function *trampoline(Function::Create(func_type, Function::ExternalLinkage, function_name, M.get()));
@@ -111,34 +177,65 @@ inline dynobj* run_null_parameter_function(function* func)
 
 		BasicBlock *BB(BasicBlock::Create(*context, "entry", trampoline));
 		new_builder.SetInsertPoint(BB);
-		Value* target_function = llvm_function((uint64_t(*)())fptr, llvm_type(size_of_return)); //cast the function to a fake fptr type.
-		Value* result_of_call = new_builder.CreateCall(target_function, {});
-
-		//START DYNAMIC. writes in both the type and the object.
-		llvm::Value* dynamic_allocator = llvm_function(new_dynamic_obj, llvm_i64()->getPointerTo(), llvm_i64());
-		llvm::Value* dynamic_object_raw = IRB->CreateCall(dynamic_allocator, llvm_integer(return_type));
-
-		llvm::Value* dynamic_actual_object_address = IRB->CreateGEP(dynamic_object_raw, llvm_integer(1));
+		auto trampoline_argument = trampoline->arg_begin();
+		Value* buffer_pointer = &*trampoline_argument++;
+		Value* arguments_pointer = &*trampoline_argument;
+		std::vector<Value*> argument_list;
+		for (uint64_t x = 0; x < number_of_arguments; ++x)
+			argument_list.push_back(new_builder.CreateLoad(x ? new_builder.CreateConstInBoundsGEP1_64(arguments_pointer, x) : arguments_pointer));
+		FunctionType* target_type = FunctionType::get(llvm_type(size_of_return), std::vector<Type*>(number_of_arguments, llvm_i64()), false);
+		Value* target_function = new_builder.CreateIntToPtr(llvm_integer((uint64_t)fptr), target_type->getPointerTo()); //cast the function to a fake fptr type.
+		Value* result_of_call = new_builder.CreateCall(target_function, argument_list);
+
+		//store the returned value into the caller's buffer
 		llvm::Type* target_pointer_type = llvm_type(size_of_return)->getPointerTo();
-		llvm::Value* dynamic_object = IRB->CreatePointerCast(dynamic_actual_object_address, target_pointer_type);
-
-		//store the returned value into the acquired address
-		IRB->CreateStore(result_of_call, dynamic_object);
-		IRB->CreateRet(IRB->CreatePtrToInt(dynamic_object_raw, llvm_i64()));
-		///FINISH DYNAMIC
+		llvm::Value* buffer_address = IRB->CreatePointerCast(buffer_pointer, target_pointer_type);
+		IRB->CreateStore(result_of_call, buffer_address);
+		IRB->CreateRetVoid();
 
 #ifndef NO_CONSOLE
 		check(!llvm::verifyFunction(*trampoline, &llvm::outs()), "verification failed");
 #endif
 
+		//this trampoline dies after one call, so it isn't put in the perf map. retiring it would rewrite the whole file on every call, and its only work is the call into the listed function.
 		auto H = c->addModule(std::move(M));
 		auto ExprSymbol = c->findUnmangledSymbol(function_name);
 
-		auto trampfptr = (uint64_t(*)())(ExprSymbol.getAddress());
-		dynobj* result = (dynobj*)trampfptr();
+		auto trampfptr = (void(*)(uint64_t*, const uint64_t*))(ExprSymbol.getAddress());
+		trampfptr(buffer, arguments);
 		c->removeModule(H);
-		return result;
 	}
+	return return_type;
+}
+
+//return value is a dynamic object to the return value. it's just the object pointer, not the type.
+//on failure, we can't get the type. since this requires a branch, we should get the type here.
+//this boxes the return value, so it's only for when the value has to become a dynamic object. otherwise, use run_function_into().
+inline dynobj* run_boxed(function* func, const uint64_t* arguments)
+{
+	if (func == 0) return 0;
+	uint64_t size_of_return = get_size(func->return_type);
+	llvm::SmallVector<uint64_t, 4> buffer(size_of_return);
+	Tptr return_type = run_function_into(func, buffer.data(), arguments);
+	if (size_of_return == 0 || return_type == 0) return 0;
+	if (return_type == u::dynamic_object) return (dynobj*)buffer[0]; //special case: if it already returns a dynamic object, don't wrap it again.
+	if (size_of_return == 1) return box_return_value(return_type, buffer[0]);
+	dynobj* result = new_dynamic_obj(return_type);
+	for (uint64_t x = 0; x < size_of_return; ++x)
+		(*result)[x] = buffer[x];
+	return result;
+}
+
+//run_function. a function with parameters doesn't run, and returns 0.
+inline dynobj* run_null_parameter_function(function* func) { return run_boxed(func, nullptr); }
+
+//run_function_with. the arguments are passed as raw words, so their type must match the parameters exactly. otherwise, returns 0.
+inline dynobj* run_function_with_arguments(function* func, Tptr argument_type, uint64_t* arguments)
+{
+	if (func == 0) return 0;
+	if (type_check(RVO, argument_type, func->parameter_type) != type_check_result::perfect_fit
+		|| type_check(RVO, func->parameter_type, argument_type) != type_check_result::perfect_fit) return 0;
+	return run_boxed(func, arguments);
 }
 #include "vector.h"
 //returns pointer-to-AST. if the vector_of_ASTs is nullptr (which only happens when the object passed in is null, use no_vector_to_AST), then it's assumed to be empty
@@ -282,7 +379,7 @@ inline void agency2(uint64_t first, uint64_t par)
 inline uint64_t overwrite_func(function* first, function* second)
 {
 	if (first == nullptr || second == nullptr) return 0;
-	if (first->return_type != second->return_type) return 0;
+	if (first->return_type != second->return_type || first->parameter_type != second->parameter_type) return 0;
 	first->~function();
 	compile_specifying_location(second->the_AST, first);
 	return 1;
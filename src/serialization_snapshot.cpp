@@ -6,6 +6,7 @@
 #include "function.h"
 #include "memory.h"
 #include "runtime.h"
+#include "trace.h"
 
 //being vectors lets us write them directly into a file, since memory is contiguous.
 extern std::vector< function*> event_roots;
@@ -58,6 +59,7 @@ extern function* function_pool;
 
 void serialize(uint64_t id)
 {
+	trace_span span("serialize");
 	std::ofstream id_file(std::to_string(id), std::ios::binary);
 	check(id_file.is_open(), "stream opening failed");
 	file_header header;
@@ -85,6 +87,7 @@ void trace_objects();
 
 void unserialize(uint64_t id)
 {
+	trace_span span("unserialize");
 	std::ifstream id_file(std::to_string(id), std::ios::binary);
 	check(id_file.is_open() && id_file.good(), "stream opening failed");
 	file_header header;
@@ -106,7 +109,9 @@ void unserialize(uint64_t id)
 
 	UNSERIALIZATION_MODE = true;
 	trace_objects(); //correct pointers, populate the type hash table, mark occupied memory, etc.
+	compile_batch batch; //all the functions go into one module
 	for (uint64_t x = 0; x < function_pool_size; ++x) //compile in place
-		if (function_pool[x].the_AST) compile_specifying_location(function_pool[x].the_AST, &function_pool[x]);	
+		if (function_pool[x].the_AST) batch.compile_specifying_location(function_pool[x].the_AST, &function_pool[x]);
+	batch.finish();
 	
 }
@@ -1,7 +1,17 @@
 #include <fstream>
+#include <numeric>
+#include <sstream>
 #include "globalinfo.h"
 #include "cs11.h"
 #include "runtime.h"
+#include "optimizer.h"
+#include "inline_cache.h"
+#include "profile.h"
+#include "perf_map.h"
+#include "trace.h"
+#include "benchmark.h"
+#include "comms.h"
+#include "binary_AST.h"
 #include "debugoutput.h"
 #include <llvm/Support/raw_ostream.h> 
 
@@ -39,7 +49,7 @@ inline void compile_returning_legitimate_object(uint64_t* memory_location, uAST*
 	}
 	else
 	{
-		function* new_location = new(allocate_function()) function(deep_AST_copier(target).result, a.return_type, a.parameter_type, a.fptr, a.result_module, std::move(a.new_context));
+		function* new_location = new(allocate_function()) function(deep_AST_copier(target).result, a.return_type, a.parameter_type, a.fptr, std::move(a.module), a.symbol_name);
 		if (VERBOSE_GC)
 		{
 			print(*new_location);
@@ -49,6 +59,32 @@ inline void compile_returning_legitimate_object(uint64_t* memory_location, uAST*
 	}
 }
 
+/* record/replay, for turning real sessions into regression runs. "record session.log" logs a fuzzer or console session. "replay session.log" runs the log again, and reports how long each step took.
+the log is text, one event per line:
+	seed N: mersenne's seed at the start.
+	ast N [...]: an AST that was compiled and run, in the console format. mersenne is reseeded with N before each one, so that [random] gives the same values in the replay.
+	gc: a GC.
+imvs that aren't integers are printed as addresses, which can't be read back. the fuzzer only makes integers.
+*/
+std::ofstream session_log;
+void record_seed(uint64_t seed)
+{
+	mersenne.seed(seed);
+	if (session_log.is_open()) session_log << "seed " << seed << '\n';
+}
+//starts an "ast" line. the caller writes the AST and the newline.
+void record_step()
+{
+	if (!session_log.is_open()) return;
+	uint64_t step_seed = mersenne();
+	mersenne.seed(step_seed);
+	session_log << "ast " << step_seed << ' ';
+}
+void record_GC()
+{
+	if (session_log.is_open()) session_log << "gc\n" << std::flush; //flushed here, so that a slow session can be grabbed while it's still running.
+}
+
 uAST** find_random_AST(function* f)
 {
 	if (f == 0) return 0;
@@ -88,6 +124,96 @@ uAST** find_random_AST(uAST*& start)
 
 std::array<uint64_t, ASTn("never reached")> hitcount;
 std::vector<uint64_t> allowed_tags;
+
+//the fuzzer's corpus is event_roots. it's a GC root, so its ASTs stay in the heap, and it's bounded by both count and words.
+uint64_t FUZZ_CORPUS_SIZE = 3; //past this many functions, a new one replaces a random old one.
+uint64_t FUZZ_CORPUS_WORDS = pool_size / 4; //past this many words of ASTs, random functions are dropped.
+std::vector<uint64_t> corpus_words; //for each function in event_roots, while fuzzing.
+std::vector<uint64_t> corpus_energy; //same. in "guided" mode, functions are picked in proportion to this, which is higher for ones that found new features.
+
+//"guided" mode: tags are picked in proportion to their energy. a tag gains energy when it finds new features, and loses it when it fails to compile without finding any.
+//so tags that mostly produce type mismatches fade, and the fuzzer spends its time where the compiler hasn't been yet. see coverage.h
+std::array<uint64_t, ASTn("never reached")> tag_energy = [] { std::array<uint64_t, ASTn("never reached")> e; e.fill(16); return e; }();
+void reward_tag(uint64_t tag, uint64_t new_features, bool compiled)
+{
+	if (new_features) tag_energy[tag] = std::min<uint64_t>(tag_energy[tag] + 16 * new_features, 1024);
+	else if (!compiled && tag_energy[tag] > 1) --tag_energy[tag];
+}
+
+//picks an index with probability proportional to its weight.
+uint64_t weighted_choice(llvm::ArrayRef<uint64_t> weights)
+{
+	uint64_t choice = generate_random() % std::accumulate(weights.begin(), weights.end(), 0ull);
+	for (uint64_t x = 0;; ++x)
+	{
+		if (choice < weights[x]) return x;
+		choice -= weights[x];
+	}
+}
+
+//event_roots has a nullptr on the back while the fuzzer picks from it, which isn't in corpus_energy.
+function* pick_corpus_entry()
+{
+	if (!FUZZ_GUIDED) return event_roots.at(generate_random() % event_roots.size());
+	llvm::SmallVector<uint64_t, 16> weights(corpus_energy.begin(), corpus_energy.end());
+	weights.push_back(1);
+	check(weights.size() == event_roots.size(), "corpus energy doesn't match the corpus");
+	return event_roots[weighted_choice(weights)];
+}
+
+std::unordered_set<uint64_t> distinct_successes; //structural hashes of the ASTs the fuzzer compiled.
+double fuzz_CPU_seconds = 0;
+
+//roughly how much of the heap an AST DAG holds.
+uint64_t AST_words(uAST* root)
+{
+	std::unordered_set<uAST*> seen{nullptr};
+	std::vector<uAST*> worklist{root};
+	uint64_t words = 0;
+	while (!worklist.empty())
+	{
+		uAST* t = worklist.back();
+		worklist.pop_back();
+		if (!seen.insert(t).second) continue;
+		words += get_full_size_of_AST(t->tag);
+		if (t->tag == ASTn("basicblock")) words += t->BBvec()->size;
+		for (uAST* field : AST_range(t))
+			worklist.push_back(field);
+	}
+	return words;
+}
+
+void add_to_corpus(function* func, uint64_t energy = 1)
+{
+	uint64_t words = AST_words(func->the_AST);
+	if (event_roots.size() > FUZZ_CORPUS_SIZE)
+	{
+		uint64_t replaced = generate_random() % event_roots.size();
+		event_roots[replaced] = func;
+		corpus_words[replaced] = words;
+		corpus_energy[replaced] = energy;
+	}
+	else
+	{
+		event_roots.push_back(func);
+		corpus_words.push_back(words);
+		corpus_energy.push_back(energy);
+	}
+	uint64_t total_words = std::accumulate(corpus_words.begin(), corpus_words.end(), 0ull);
+	while (total_words > FUZZ_CORPUS_WORDS && event_roots.size() > 1)
+	{
+		uint64_t dropped = generate_random() % event_roots.size();
+		total_words -= corpus_words[dropped];
+		event_roots[dropped] = event_roots.back();
+		corpus_words[dropped] = corpus_words.back();
+		corpus_energy[dropped] = corpus_energy.back();
+		event_roots.pop_back();
+		corpus_words.pop_back();
+		corpus_energy.pop_back();
+	}
+}
+void adopt_farm_ASTs(); //defined after source_reader, which it needs.
+
 //each of these is a basicblock AST.
 /**
 The fuzztester generates random ASTs and attempts to compile them. not all randomly-generated ASTs will be well-formed.
@@ -103,22 +229,31 @@ and, it can't produce [concatenate [int]a [load a]]. that requires speculative c
 */
 void fuzztester(uint64_t iterations)
 {
-	uint64_t max_fuzztester_size = 3;
+	corpus_words.assign(event_roots.size(), 0);
+	corpus_energy.assign(event_roots.size(), 1);
+	uint64_t iterations_done = 0;
+	std::clock_t start = std::clock();
 	while (iterations)
 	{
 		--iterations; //this is here, instead of having "iterations--", so that integer-sanitizer doesn't complain about decrementing past 0
+		if (FARM_WORKER)
+		{
+			adopt_farm_ASTs();
+			if (iterations_done % 100 == 0) report_farm_stats(iterations_done, llvm::ArrayRef<uint64_t>(hitcount.data(), hitcount.size()));
+		}
+		++iterations_done;
 		event_roots.push_back(nullptr); //we this is so that we always have something to find, when we're looking for previous ASTs
 		//create a random AST
-		uint64_t tag = mersenne() % ASTn("never reached");
+		uint64_t tag = FUZZ_GUIDED ? weighted_choice(llvm::ArrayRef<uint64_t>(tag_energy.data(), tag_energy.size())) : mersenne() % ASTn("never reached");
 		if (LIMITED_FUZZ_CHOICES) tag = allowed_tags[mersenne() % allowed_tags.size()];
 
-		function* previous_func = event_roots.at(generate_random() % event_roots.size());
+		function* previous_func = pick_corpus_entry();
 		uAST** previous_possible = find_random_AST(previous_func);
 		uAST* previous_full = previous_func ? previous_func->the_AST : 0;
 		uAST* test_AST;
 		if (tag == ASTn("basicblock")) //simply concatenate two previous basic blocks.
 		{
-			function* second_prev_func = event_roots.at(generate_random() % event_roots.size());
+			function* second_prev_func = pick_corpus_entry();
 			uAST** sec_previous_possible = find_random_AST(second_prev_func);
 			test_AST = new_AST(tag, {previous_possible ? *previous_possible : 0, sec_previous_possible ? *sec_previous_possible : 0});
 		}
@@ -163,23 +298,33 @@ void fuzztester(uint64_t iterations)
 
 		output_AST_console_version(test_AST);
 		event_roots.pop_back(); //delete the null we put on the back
-		finiteness = FINITENESS_LIMIT;
+		record_step();
+		if (session_log.is_open()) session_log << *test_AST << '\n';
+		start_finiteness_budget();
 
 		uint64_t result[3];
+		uint64_t features_before = features_seen;
 		compile_returning_legitimate_object(result, test_AST);
 		print("results of user compile are ", result[0], ' ', result[1], ' ', result[2], '\n');
+		reward_tag(tag, features_seen - features_before, result[1] == 0);
 		auto func = (function*)result[0];
 		if (result[1] == 0)
 		{
-			if (event_roots.size() > max_fuzztester_size)
-				event_roots[generate_random() % event_roots.size()] = func;
-			else event_roots.push_back(func);
-
+			add_to_corpus(func, std::min<uint64_t>(1 + features_seen - features_before, 64));
+			distinct_successes.insert(structural_hash(test_AST));
+			if (FARM_WORKER)
+			{
+				std::stringstream AST_text;
+				AST_text << *test_AST;
+				share_farm_AST(AST_text.str());
+			}
 
 			if (DONT_ADD_MODULE_TO_ORC || DELETE_MODULE_IMMEDIATELY)
 				continue;
 
+			uint64_t features_before_run = features_seen;
 			dynobj* dynamic_result = run_null_parameter_function((function*)result[0]);
+			reward_tag(tag, features_seen - features_before_run, true);
 			uint64_t size_of_return = dynamic_result ? get_size(dynamic_result->type) : 0;
 			if (size_of_return) output_array(&(*dynamic_result)[0], size_of_return);
 			//theoretically, this action is disallowed. these ASTs are pointing to already-immuted ASTs, which can't happen. however, it's safe as long as we isolate these ASTs from the user
@@ -189,13 +334,20 @@ void fuzztester(uint64_t iterations)
 		if (INTERACTIVE)
 		{
 			print("Press enter to continue\n");
+			flush_log();
 			std::cin.get();
 		}
 		print("\n");
 		if ((generate_random() % (GC_TIGHT ? 1 : 30)) == 0)
+		{
+			record_GC();
 			start_GC();
+		}
 	}
 	event_roots.clear();
+	corpus_words.clear();
+	corpus_energy.clear();
+	fuzz_CPU_seconds += (std::clock() - start) / (double)CLOCKS_PER_SEC;
 }
 
 
@@ -295,7 +447,7 @@ private:
 			return new_type_location;
 		}
 		string tag_str = get_token();
-		print("tag_str was (", tag_str, ")");
+		print_at(log_level::debug, "tag_str was (", tag_str, ")");
 		uint64_t AST_type = ASTn(tag_str.c_str());
 
 		std::vector<uAST*> dummy_uASTs(get_size(get_AST_fields_type(AST_type)), nullptr);
@@ -444,8 +596,66 @@ void cannot_compile_string(std::string input_string)
 	check(compile_returning_just_function(end) == 0, "compile succeeded when it shouldn't have");
 }
 
+uAST* optimize_string(std::string input_string)
+{
+	std::stringstream div_test_stream;
+	div_test_stream << input_string << '\n';
+	source_reader k(div_test_stream, '\n');
+	uAST* end = k.read();
+	check(end != nullptr, "failed to make AST");
+	return optimize_AST(end);
+}
+
+function* compile_function_string(std::string input_string)
+{
+	std::stringstream div_test_stream;
+	div_test_stream << input_string << '\n';
+	source_reader k(div_test_stream, '\n');
+	uAST* end = k.read();
+	check(end != nullptr, "failed to make AST");
+	function* result = compile_returning_just_function(end);
+	check(result != nullptr, "failed to compile");
+	return result;
+}
+
+//allocations made by one run of the function.
+uint64_t allocations_when_run(function* f)
+{
+	llvm::SmallVector<uint64_t, 4> return_buffer(get_size(f->return_type));
+	uint64_t allocations_before = allocation_count;
+	finiteness = FINITENESS_LIMIT;
+	run_function_into(f, return_buffer.data());
+	return allocation_count - allocations_before;
+}
+
+//"callee" in the input string names a function pointer imv for f, so that run_function sees a constant.
+void compile_verify_calling(std::string input_string, function* f, uint64_t value)
+{
+	check(f != nullptr, "callee didn't compile");
+	std::stringstream div_test_stream;
+	div_test_stream << input_string << '\n';
+	source_reader k(div_test_stream, '\n');
+	dynobj* callee = new_dynamic_obj(u::function_pointer);
+	(*callee)[0] = (uint64_t)f;
+	k.ASTmap.insert({"callee", (uAST*)callee});
+	uAST* end = k.read();
+	check(end != nullptr, "failed to make AST");
+	finiteness = FINITENESS_LIMIT;
+	function* caller = compile_returning_just_function(end);
+	check(caller != nullptr, "failed to compile");
+	dynobj* result = run_null_parameter_function(caller); //the caller returns a dynamic object, so this is the callee's boxed value.
+	check(result && result->type == u::integer && (*result)[0] == value, "run_function on a constant callee gave the wrong value");
+}
+
 void test_suite()
 {
+	//every compile in the suite also checks that the validator agrees with generate_IR().
+	bool old_crosscheck = VALIDATOR_CROSSCHECK;
+	VALIDATOR_CROSSCHECK = true;
+	//the expected values count finiteness in calls.
+	budget_model old_budget_model = BUDGET_MODEL;
+	BUDGET_MODEL = budget_model::calls;
+
 	//try moving the type check to the back as well.
 	Tptr unique_zero = new_unique_type(Typen("integer"), {});
 	check(unique_zero == new_unique_type(Typen("integer"), {}), "duplicated type doesn't even unique");
@@ -473,8 +683,23 @@ void test_suite()
 	//looping until finiteness ends, increasing a value. tests storing values
 	compile_verify_string("_b[imv 0] _a[label] [store b [increment b]] [goto a] [concatenate b]", u::integer, FINITENESS_LIMIT);
 
+	//labels are canonical loops. two gotos share the latch. the second goto only runs once the first has failed, and then it fails too.
+	//at level 2, the loop passes run on them.
+	uint64_t old_optimization_level = OPTIMIZATION_LEVEL;
+	for (uint64_t level : {0, 2})
+	{
+		OPTIMIZATION_LEVEL = level;
+		compile_verify_string("_b[imv 0] _a[label] [store b [increment b]] [goto a] [concatenate b]", u::integer, FINITENESS_LIMIT);
+		compile_verify_string("_b[imv 0] _a[label] [store b [increment b]] [goto a] [store b [increment b]] [goto a] [concatenate b]", u::integer, FINITENESS_LIMIT + 1);
+	}
+	OPTIMIZATION_LEVEL = old_optimization_level;
+
 	//vector creation and pushback
 	compile_string("_vec[nvec [typeof [zero]]] [vecpb vec [imv 40]] [concatenate vec]");
+	//the fourth pushback has to reallocate, since new vectors reserve 3 elements.
+	std::string five_elements = "_vec[nvec [typeof [zero]]] [vecpb vec [imv 1]] [vecpb vec [imv 2]] [vecpb vec [imv 3]] [vecpb vec [imv 4]] [vecpb vec [imv 5]] ";
+	compile_verify_string(five_elements + "[add [vecsz vec] [multiply [load_subobj vec [imv 4]] [imv 10]]]", u::integer, 55);
+	compile_verify_string(five_elements + "[load_subobj vec [imv 5]]", u::integer, 0); //out of bounds
 
 	//loading from dynamic objects. a single-object dynamic object, pointing to an int.
 	compile_verify_string("_empty[dynamify] _ret[imv 0] _a[imv 40] _subobj[dyn_subobj _dyn[dynamify [imv 40]] [imv 0] [label] [store ret subobj] [store empty subobj]] [concatenate ret]", u::integer, 40);
@@ -503,6 +728,11 @@ void test_suite()
 	//loading a subobject from a concatenation, as well as copying across fields of a concatenation
 	compile_verify_string("_co[concatenate _s[imv 20] [increment s]] [load_subobj [pointer co] [imv 1]]", u::integer, 20 + 1);
 
+	//4 words are copied whole. between two stack objects, that's a memcpy. storing an object into itself overlaps, so it's a memmove.
+	std::string four_words = "_a[concatenate [concatenate [imv 1] [imv 2]] [concatenate [imv 3] [imv 4]]] ";
+	compile_verify_string(four_words + "_b[concatenate [concatenate [zero] [zero]] [concatenate [zero] [zero]]] [store b a] [load_subobj [pointer b] [imv 3]]", u::integer, 4);
+	compile_verify_string(four_words + "[store a a] [load_subobj [pointer a] [imv 2]]", u::integer, 3);
+
 	//goto forward. should skip the second store, and produce 20.
 	compile_verify_string("_b[imv 0] _a[label {[store b [imv 20]] [goto a] [store b [imv 40]]}] [concatenate b]", u::integer, 20);
 
@@ -517,16 +747,386 @@ void test_suite()
 	cannot_compile_string("[concatenate _ant[imv 40] [pointer ant]]");
 	//can't get a reference to ant either.
 	cannot_compile_string("[concatenate _ant[imv 40] [store ant [imv 40]]]");
+	//the offset must be a constant. the validator has to know that [add [imv 1] [zero]] folds, but [random] doesn't.
+	compile_verify_string("_co[concatenate _s[imv 20] [increment s]] [load_subobj [pointer co] [add [imv 1] [zero]]]", u::integer, 20 + 1);
+	cannot_compile_string("_co[concatenate _s[imv 20] [increment s]] [load_subobj [pointer co] [random]]");
 
 
 	//compile_string("[run_function [compile [convert_to_AST [system1 [imv 2]] [label] {[imv 0]v [dynamify [pointer v]]}]]]");
 	//compile_string("[run_function [compile [convert_to_AST [imv 1] [label] [dynamify]]]]"); //produces 0 inside the dynamic object, using the zero AST.
 	//future: implement vectors, then test them here
 
+	//AST optimizer. crosscheck mode checks that the optimized AST has the same type as the user's AST.
+	bool old_AST_optimize = AST_OPTIMIZE;
+	AST_OPTIMIZE = true;
+	compile_verify_string("[add [imv 2] [multiply [imv 3] [imv 4]]]", u::integer, 14);
+	compile_verify_string("[if [lessu [imv 1] [imv 2]] [imv 5] [imv 6]]", u::integer, 5);
+	compile_verify_string("{[imv 1] {[imv 2] [imv 3]}}", u::integer, 3);
+	compile_verify_string("_b[imv 0] _a[label {[store b [imv 20]] [goto a] [store b [imv 40]]}] [concatenate b]", u::integer, 20);
+	//the label after the forward goto is unreachable from inside, but the goto at the end still jumps to it, so it can't be dropped.
+	compile_verify_string("_b[imv 0] _a[label {[goto a] _l[label] [store b [increment b]]}] [goto l] [concatenate b]", u::integer, FINITENESS_LIMIT);
+	AST_OPTIMIZE = old_AST_optimize;
+
+	uAST* folded = optimize_string("[add [imv 2] [multiply [imv 3] [imv 4]]]");
+	check(folded->tag == ASTn("basicblock") && folded->BBvec()->size == 1, "AST optimizer changed the basic block");
+	uAST* folded_element = (uAST*)(*folded->BBvec())[0];
+	check(folded_element->tag == ASTn("imv") && (*(dynobj*)folded_element->fields[0])[0] == 14, "AST optimizer didn't fold arithmetic");
+	check(optimize_string("{[imv 1] {[imv 2] [imv 3]}}")->BBvec()->size == 3, "AST optimizer didn't flatten basic blocks");
+	svector* shared = optimize_string("[add [random] [imv 4]] [multiply [random] [imv 4]]")->BBvec();
+	check(((uAST*)(*shared)[0])->fields[1] == ((uAST*)(*shared)[1])->fields[1], "AST optimizer didn't share equal constants");
+	uAST* kept_if = (uAST*)(*optimize_string("[if [imv 1] [add _x[random] [imv 1]] [zero]] [concatenate x]")->BBvec())[0];
+	check(kept_if->tag == ASTn("if"), "AST optimizer removed an if whose branch is referred to from outside");
+
+	//run_function on a constant function. the first callee is small enough to compile into the caller, twice. the second has a label, so it's called directly.
+	std::stringstream small_stream("[add [imv 2] [imv 3]]\n"), labeled_stream("_a[label] [imv 7]\n");
+	source_reader small_reader(small_stream, '\n'), labeled_reader(labeled_stream, '\n');
+	function* small_callee = compile_returning_just_function(small_reader.read());
+	function* labeled_callee = compile_returning_just_function(labeled_reader.read());
+	compile_verify_calling("[run_function [imv callee]] [run_function [imv callee]]", small_callee, 5);
+	compile_verify_calling("[run_function [imv callee]]", labeled_callee, 7);
+
+	//the typed call writes into the caller's buffer, and shouldn't allocate anything, even for a return value too big for a register.
+	std::stringstream pair_stream("[concatenate [imv 3] [imv 4]]\n");
+	source_reader pair_reader(pair_stream, '\n');
+	function* pair_function = compile_returning_just_function(pair_reader.read());
+	check(pair_function != nullptr, "failed to compile");
+	uint64_t return_buffer[2] = {0, 0};
+	uint64_t allocations_before = allocation_count;
+	finiteness = FINITENESS_LIMIT;
+	check(run_function_into(small_callee, return_buffer) == u::integer && return_buffer[0] == 5, "typed call gave the wrong value");
+	check(run_function_into(pair_function, return_buffer) == pair_function->return_type && return_buffer[0] == 3 && return_buffer[1] == 4, "typed call through the trampoline gave the wrong value");
+	check(allocation_count == allocations_before, "typed call allocated");
+
+	//parameters. they're ordered by when they're compiled, so the first parameter here is the left one.
+	std::stringstream parameter_stream("[add [parameter [typeof [imv 0]]] [multiply [parameter [typeof [imv 0]]] [imv 10]]]\n");
+	source_reader parameter_reader(parameter_stream, '\n');
+	function* parameter_function = compile_returning_just_function(parameter_reader.read());
+	check(parameter_function != nullptr, "failed to compile parameters");
+	check(get_size(parameter_function->parameter_type) == 2, "wrong parameter type");
+	uint64_t arguments[2] = {1, 2};
+	finiteness = FINITENESS_LIMIT;
+	check(run_function_into(parameter_function, return_buffer, arguments) == u::integer && return_buffer[0] == 21, "parameters were passed wrong");
+	check(run_null_parameter_function(parameter_function) == nullptr, "function with parameters ran without arguments");
+	compile_verify_calling("[run_function_with [imv callee] [concatenate [imv 3] [imv 4]]]", parameter_function, 43); //the direct call, which passes the arguments in registers.
+	check(run_function_with_arguments(parameter_function, u::integer, arguments) == nullptr, "arguments of the wrong type were passed");
+	cannot_compile_string("[parameter [imv 0]]");
+
+	//escape analysis. a pointer that stays in the function leaves its target on the stack. one that's returned or given to a call moves it to the heap.
+	check(allocations_when_run(compile_function_string("_a[imv 400] _p[pointer a] _q[concatenate p [imv 1]] [load_subobj [load_subobj q [zero]] [zero]]")) == 0, "pointer target that doesn't escape was moved to the heap");
+	check(allocations_when_run(compile_function_string("_a[imv 400] [pointer a]")) == 1, "returned pointer's target wasn't moved to the heap");
+	check(allocations_when_run(compile_function_string("_a[imv 400] [dynamify [pointer a]]")) == 2, "pointer given to a call didn't move its target to the heap");
+	//a stack object is made once per call, not once per pass through a label. the second pass writes 1 into the same t that keep still points to.
+	compile_verify_string("_n[imv 0] _keep[pointer n] _old[imv 0] _a[label] _t[concatenate n] [store old [load_subobj keep [zero]]] [store keep [pointer t]] [store n [increment n]] [if [lessu n [imv 2]] [goto a] {}] [concatenate old]", u::integer, 1);
+	cannot_compile_string("_o[imv 0] _p[concatenate o o] _q[concatenate p p] [parameter [typeof [concatenate q [concatenate p p]]]]"); //8 words don't fit in registers
+
+	//inline caches. the first run misses and fills the cache, the second hits. after a flush, it misses again.
+	function* cached_site = compile_function_string("_empty[dynamify] _ret[imv 0] _subobj[dyn_subobj _dyn[dynamify [imv 40]] [imv 0] [label] [store ret subobj] [store empty subobj]] [concatenate ret]");
+	check(cached_site->module->inline_caches.size() == 1, "dyn_subobj didn't get an inline cache");
+	dyn_subobj_cache& cache = *cached_site->module->inline_caches[0];
+	uint64_t cached_result = 0;
+	for (int x = 0; x < 2; ++x)
+	{
+		finiteness = FINITENESS_LIMIT;
+		run_function_into(cached_site, &cached_result);
+		check(cached_result == 40, "dyn_subobj through the inline cache loaded the wrong value");
+	}
+	check(cache.misses == 1 && cache.hits == 1, "inline cache didn't hit on the second run");
+	flush_inline_caches();
+	run_function_into(cached_site, &cached_result);
+	check(cache.misses == 2 && cache.hits == 1, "flushed inline cache still hit");
+
+	//finiteness lives in a local, and is written back around calls. running the caller spends 1, and the loop spends 2 per iteration, so the 5th iteration runs out.
+	std::string calling_loop = "_b[imv 0] _a[label] [store b [increment b]] [run_function [imv callee]] [goto a] [concatenate b]";
+	compile_verify_calling(calling_loop, small_callee, 5); //inlined, so the callee spends the local directly
+	check(finiteness == 0, "finiteness wasn't written back at the return");
+	compile_verify_calling(calling_loop, labeled_callee, 5); //called directly, so the local is spilled and reloaded around the call
+
+	//under the work model, the loop costs 3 per iteration: store, increment, and goto. 9 is left after running the function.
+	BUDGET_MODEL = budget_model::work;
+	compile_verify_string("_b[imv 0] _a[label] [store b [increment b]] [goto a] [concatenate b]", u::integer, 4);
+	//under the time model, a run with no time left gets one slice. a run with time left gets more.
+	BUDGET_MODEL = budget_model::time;
+	function* timed_loop = compile_function_string("_b[imv 0] _a[label] [store b [increment b]] [goto a] [concatenate b]");
+	uint64_t old_time_limit = TIME_LIMIT_MICROSECONDS;
+	uint64_t timed_result = 0;
+	for (uint64_t limit : {0, 1000})
+	{
+		TIME_LIMIT_MICROSECONDS = limit;
+		start_finiteness_budget();
+		run_function_into(timed_loop, &timed_result);
+		check(limit ? timed_result > TIME_SLICE : timed_result == TIME_SLICE, "time budget gave the wrong number of slices");
+	}
+	TIME_LIMIT_MICROSECONDS = old_time_limit;
+	BUDGET_MODEL = old_budget_model;
+
+	//profiling. the loop runs the increment once per iteration. with profiling off, nothing is counted.
+	std::string counted_loop = "_b[imv 0] _a[label] [store b [increment b]] [goto a] [concatenate b]";
+	bool old_profile = PROFILE_ASTS;
+	PROFILE_ASTS = false;
+	check(compile_function_string(counted_loop)->module->AST_counters.empty(), "profiling is off, but ASTs got counters");
+	PROFILE_ASTS = true;
+	function* profiled = compile_function_string(counted_loop);
+	allocations_when_run(profiled);
+	uint64_t increments = 0;
+	for (AST_counter& counter : profiled->module->AST_counters)
+		if (counter.tag == ASTn("increment")) increments += counter.count;
+	check(increments == FINITENESS_LIMIT, "profile counted the wrong number of runs");
+	PROFILE_ASTS = old_profile;
+
+	//the perf map names functions by structural hash, which mustn't depend on where the ASTs were allocated. labels make cycles, which it has to stop at.
+	auto hash_of = [](std::string input) { std::stringstream stream(input + '\n'); source_reader k(stream, '\n'); return structural_hash(k.read()); };
+	check(hash_of(counted_loop) == hash_of(counted_loop), "structural hash depends on AST addresses");
+	check(hash_of("[imv 1]") != hash_of("[imv 2]"), "structural hash ignores imv integers");
+	check(hash_of("_a[imv 1] [add a a]") != hash_of("[add [imv 1] [imv 1]]"), "structural hash ignores sharing");
+
+	//session logs store ASTs in the console format, so printing an AST and reading it back must give the same function.
+	std::string seven_loop = "_b[imv 7] _a[label] [store b [increment b]] [goto a] [concatenate b]";
+	std::stringstream seven_loop_stream(seven_loop + '\n'), printed_AST;
+	printed_AST << *source_reader(seven_loop_stream, '\n').read();
+	compile_verify_string(printed_AST.str(), u::integer, (*compile_string(seven_loop))[0]);
+
+	//binary ASTs. decoding keeps the structure, including the sharing and the cycle through the label, so it's the same function.
+	std::string label_cycle = "_b[imv 0] _a[label {[goto a] _l[label] [store b [increment b]]}] [goto l] [concatenate b]";
+	std::stringstream label_cycle_stream(label_cycle + '\n');
+	uAST* text_AST = source_reader(label_cycle_stream, '\n').read();
+	std::vector<uint64_t> encoded_AST = encode_binary_AST(text_AST);
+	uAST* decoded_AST = decode_binary_AST(encoded_AST);
+	check(structural_hash(decoded_AST) == structural_hash(text_AST), "binary AST changed the structure");
+	check(encode_binary_AST(decoded_AST) == encoded_AST, "binary AST encoding isn't stable");
+	finiteness = FINITENESS_LIMIT;
+	dynobj* decoded_result = run_null_parameter_function(compile_returning_just_function(decoded_AST));
+	check(decoded_result && (*decoded_result)[0] == FINITENESS_LIMIT, "binary AST compiled to a different function");
+	//imvs that hold pointers go by name.
+	dynobj* pointer_object = new_dynamic_obj(new_unique_type(Typen("pointer"), {u::integer}));
+	(*pointer_object)[0] = (uint64_t)new_object_value(5);
+	uAST* pointer_imv = new_AST(ASTn("imv"), {(uAST*)pointer_object});
+	uAST* decoded_imv = decode_binary_AST(encode_binary_AST(pointer_imv, {{(uAST*)pointer_object, "object"}}), {{"object", (uAST*)pointer_object}});
+	check(decoded_imv->fields[0] == (uAST*)pointer_object, "binary AST lost an external object");
+
+	//the farm's queues. 8 words is a 3 word header and room for 5, of which one is always left empty. messages wrap around the end.
+	uint64_t old_mmap_size = mmap_size;
+	mmap_size = 8 * sizeof(uint64_t);
+	std::array<std::atomic<uint64_t>, 8> queue_memory;
+	multiple_sender_queue queue(queue_memory.data());
+	queue.initialize();
+	for (uint64_t round = 0; round < 3; ++round)
+	{
+		check(queue.try_write_values({round, round + 1, round + 2}), "queue with room refused a message");
+		check(!queue.try_write_values({round, round}), "full queue took a message");
+		for (uint64_t x = 0; x < 3; ++x)
+			check(queue.should_I_load() && queue.get_next_value() == round + x, "queue lost a value");
+		check(!queue.should_I_load(), "empty queue has values");
+	}
+	mmap_size = old_mmap_size;
+
+	//coverage. a new AST sets new features, the same one again doesn't, and errors count too.
+	bool old_guided = FUZZ_GUIDED;
+	FUZZ_GUIDED = true;
+	uint64_t features_at_start = features_seen;
+	compile_function_string("[lesss [imv 1] [imv 2]]");
+	uint64_t features_after_compile = features_seen;
+	check(features_after_compile > features_at_start, "compiling didn't record features");
+	compile_function_string("[lesss [imv 1] [imv 2]]");
+	check(features_seen == features_after_compile, "compiling the same AST again found new features");
+	cannot_compile_string("[lesss [imv 1] [concatenate [imv 1] [imv 2]]]");
+	check(features_seen > features_after_compile, "an error didn't record a feature");
+	FUZZ_GUIDED = old_guided;
+	for (uint64_t x = 0; x < 10; ++x)
+		check(weighted_choice({0, 5, 0}) == 1, "weighted choice picked a zero weight");
+
+	//tracing. spans are only recorded while it's on.
+	bool old_tracing = TRACING;
+	TRACING = false;
+	uint64_t traced_before = count_traced_spans("generate_IR");
+	compile_function_string(counted_loop);
+	check(count_traced_spans("generate_IR") == traced_before, "tracing is off, but a span was recorded");
+	TRACING = true;
+	uint64_t runs_before = count_traced_spans("run_function");
+	allocations_when_run(compile_function_string(counted_loop));
+	check(count_traced_spans("generate_IR") == traced_before + 1 && count_traced_spans("run_function") == runs_before + 1, "tracing missed a span");
+	TRACING = old_tracing;
+
+	//logging. a message below the level is dropped before it reaches the buffer. the flusher only ever shrinks the buffer, so these can't be fooled by it.
+	bool old_quiet = QUIET;
+	log_level old_level = LOG_LEVEL;
+	QUIET = false;
+	LOG_LEVEL = log_level::warning;
+	uint64_t log_bytes_before = buffered_log_bytes();
+	print("this info message should be dropped\n");
+	check(buffered_log_bytes() <= log_bytes_before, "a message below the log level was buffered");
+	print_at(log_level::warning, "log level test\n");
+	flush_log();
+	check(buffered_log_bytes() == 0, "flush_log left output in the buffer");
+	LOG_LEVEL = old_level;
+	QUIET = old_quiet;
+
+	VALIDATOR_CROSSCHECK = old_crosscheck;
+
 	//debugtypecheck(T::does_not_return); stopped working after type changes to bake in tags into the pointer. this is useless anyway, in a unity build.
 }
 #endif
 
+//compiles the ASTs that other farm workers shared, and adds the ones that compile to the corpus.
+void adopt_farm_ASTs()
+{
+	string AST_text;
+	while (receive_farm_AST(AST_text))
+	{
+		std::stringstream stream(AST_text + '\n');
+		uAST* shared = source_reader(stream, '\n').read();
+		uint64_t result[3];
+		start_finiteness_budget();
+		compile_returning_legitimate_object(result, shared);
+		if (result[1] == 0) add_to_corpus((function*)result[0]);
+	}
+}
+
+//see benchmark.h. the microbenchmarks only make garbage, so a GC before each sample gives every sample the same empty heap.
+void benchmark_suite(uint64_t seed, const string& filename)
+{
+	mersenne.seed(seed);
+	benchmark_recorder results;
+	const uint64_t samples = 100;
+	auto parse = [](const string& input) { std::stringstream stream(input + '\n'); source_reader k(stream, '\n'); uAST* result = k.read(); check(result != nullptr, "failed to make AST"); return result; };
+	auto repeat = [](const string& piece, uint64_t count) { string result; for (uint64_t x = 0; x < count; ++x) result += piece; return result; };
+	std::string counted_loop = "_b[imv 0] _a[label] [store b [increment b]] [goto a] [concatenate b]";
+
+	for (uint64_t s = 0; s < samples; ++s)
+	{
+		start_GC();
+		results.measure("allocate 4 words", 1, 1000, [] { allocate(4); });
+		Tptr pointer_model = new_local_type(allocate, Typen("pointer"), {u::integer});
+		results.measure("uniquefy_premade_type", 1, 1000, [&] { uniquefy_premade_type(pointer_model, true); });
+		Tptr pointer = new_unique_type(Typen("pointer"), {u::integer});
+		Tptr object = concatenate_types({u::integer, pointer, u::integer});
+		Tptr other_object = concatenate_types({u::integer, u::integer, pointer});
+		results.measure("type_check, same type", 1, 1000, [&] { type_check(RVO, object, object); });
+		results.measure("type_check, different types", 1, 1000, [&] { type_check(RVO, object, other_object); });
+		uAST* loop = parse(counted_loop);
+		results.measure("deep_AST_copier, counted loop", 1, 100, [&] { deep_AST_copier copy(loop); });
+		results.measure("vector_build, 64 pushback_int", 1, 20, [] { svector* v = new_vector(); for (uint64_t x = 0; x < 64; ++x) pushback_int(v, x); });
+	}
+
+	//loading a program, from the text format and from the binary one. both start from memory, so neither includes reading a file.
+	string hundred_statements = "_b[imv 0] " + repeat("[store b [increment b]] ", 100) + "[concatenate b]";
+	for (uint64_t s = 0; s < samples; ++s)
+	{
+		start_GC();
+		std::vector<uint64_t> encoded = encode_binary_AST(parse(hundred_statements));
+		results.measure("load, text, 100 statements", 1, 10, [&] { parse(hundred_statements); });
+		results.measure("load, binary, 100 statements", 1, 10, [&] { decode_binary_AST(encoded); });
+	}
+
+	//start_GC on heaps of different shapes. the live objects are a function's AST, which event_roots keeps alive.
+	auto time_GC = [&](const string& name) { uint64_t start = benchmark_now(); start_GC(); results.record(name, benchmark_now() - start); };
+	auto make_garbage = [](uint64_t objects) { for (uint64_t x = 0; x < objects; ++x) allocate(2); };
+	for (uint64_t s = 0; s < samples; ++s)
+	{
+		start_GC();
+		time_GC("start_GC, empty heap");
+		make_garbage(10000);
+		time_GC("start_GC, 10000 dead objects");
+	}
+	event_roots.push_back(compile_function_string(repeat("[imv 1] ", 500)));
+	for (uint64_t s = 0; s < samples; ++s)
+	{
+		time_GC("start_GC, 500 live ASTs");
+		make_garbage(5000);
+		time_GC("start_GC, 500 live ASTs and 5000 dead objects");
+	}
+	event_roots.pop_back();
+
+	//compile latency, by the shape of the AST. parsing isn't timed.
+	std::pair<string, string> shapes[] = {
+		{"arithmetic", "[add [imv 1] [multiply [imv 2] [imv 3]]]"},
+		{"branch", "[if [lessu [imv 1] [imv 2]] [imv 5] [imv 6]]"},
+		{"pointers", "_a[imv 400] _p[pointer a] _q[concatenate p [imv 1]] [load_subobj [load_subobj q [zero]] [zero]]"},
+		{"loop", counted_loop},
+		{"100 statements", hundred_statements},
+	};
+	for (auto& shape : shapes)
+		for (uint64_t s = 0; s < samples; ++s)
+		{
+			start_GC();
+			uAST* target = parse(shape.second);
+			uint64_t start = benchmark_now();
+			function* compiled = compile_returning_just_function(target);
+			results.record("compile, " + shape.first, benchmark_now() - start);
+			check(compiled != nullptr, "benchmark AST didn't compile");
+		}
+
+	//run latency. these include the recompile when a function gets hot, which is why the percentiles matter.
+	start_GC();
+	function* constant = compile_function_string("[imv 3]");
+	function* loop = compile_function_string(counted_loop);
+	uint64_t return_buffer;
+	results.measure("run, constant", samples, 100, [&] { start_finiteness_budget(); run_function_into(constant, &return_buffer); });
+	results.measure("run, counted loop", samples, 1, [&] { start_finiteness_budget(); run_function_into(loop, &return_buffer); });
+
+	//the fuzzer's GCs come from mersenne, so they land in the same iterations every run.
+	for (uint64_t s = 0; s < 10; ++s)
+	{
+		uint64_t start = benchmark_now();
+		fuzztester(100);
+		results.record("fuzzer iteration", (double)(benchmark_now() - start) / 100, 100);
+	}
+
+	std::ofstream output(filename, std::ofstream::trunc);
+	check(output.is_open(), "couldn't open " + filename);
+	results.write_json(output, seed);
+}
+
+//runs a log from "record", and prints each step's timings in microseconds. the fuzzer and console only run ASTs that compiled, and so does this.
+void replay_session(const string& filename)
+{
+	std::ifstream log(filename);
+	check(log.is_open(), "couldn't open " + filename);
+	uint64_t step = 0;
+	double total_compile = 0, total_run = 0, total_GC = 0;
+	for (string kind; log >> kind; ++step)
+	{
+		if (kind == "seed")
+		{
+			uint64_t seed;
+			log >> seed;
+			mersenne.seed(seed);
+		}
+		else if (kind == "gc")
+		{
+			uint64_t start = benchmark_now();
+			start_GC();
+			double GC_time = (benchmark_now() - start) / 1000.0;
+			total_GC += GC_time;
+			std::cout << "step " << step << " gc " << GC_time << '\n';
+		}
+		else if (kind == "ast")
+		{
+			uint64_t step_seed;
+			log >> step_seed;
+			mersenne.seed(step_seed);
+			source_reader k(log, '\n');
+			uAST* target = k.read();
+			start_finiteness_budget();
+			uint64_t start = benchmark_now();
+			uint64_t result[3];
+			compile_returning_legitimate_object(result, target);
+			double compile_time = (benchmark_now() - start) / 1000.0;
+			double run_time = 0;
+			if (result[1] == 0 && !DONT_ADD_MODULE_TO_ORC && !DELETE_MODULE_IMMEDIATELY)
+			{
+				start = benchmark_now();
+				run_null_parameter_function((function*)result[0]);
+				run_time = (benchmark_now() - start) / 1000.0;
+			}
+			total_compile += compile_time;
+			total_run += run_time;
+			std::cout << "step " << step << " ast compile " << compile_time << " run " << run_time << " error " << result[1] << '\n';
+		}
+		else error("unrecognized event in session log: " + kind);
+	}
+	std::cout << "total compile " << total_compile << " run " << total_run << " gc " << total_GC << '\n';
+}
+
 void initialize()
 {
 	u::vector_of_ASTs = new_unique_type(Typen("vector"), u::AST_pointer);
@@ -544,17 +1144,57 @@ int main(int argc, char* argv[])
 	TM = TM_backer.get();
 	KaleidoscopeJIT c_holder(TM); //purpose is to make valgrind happy by deleting the compiler_host at the end of execution
 	c = &c_holder;
+	install_trace_signals();
 
 	bool unserialize_choice = false;
 	uint64_t unserializationid;
 	std::ifstream file;
+	string program_file;
+	string binary_output_file;
 
 	bool BENCHMARK = false;
+	string benchmark_file; //if set, the benchmark suite runs instead of everything else.
+	string replay_file; //same
+	bool seeded = false;
+	uint64_t seed = 1; //for the benchmark suite. other modes are only seeded if "seed" is given.
+	auto read_number = [&](int& x) -> uint64_t
+	{
+		check(x + 1 < argc, string("no number after ") + argv[x]);
+		string next_token = argv[++x];
+		check(next_token.size(), "no digits in the number");
+		for (auto& k : next_token)
+			check(isdigit(k), string("tried to input non-number ") + next_token);
+		return std::stoull(next_token);
+	};
 	for (int x = 1; x < argc; ++x)
 	{
 		if (strcmp(argv[x], "interactive") == 0) INTERACTIVE = true;
-		else if (strcmp(argv[x], "verbose") == 0) VERBOSE_DEBUG = true;
-		else if (strcmp(argv[x], "optimize") == 0) OPTIMIZE = true;
+		else if (strcmp(argv[x], "verbose") == 0)
+		{
+			VERBOSE_DEBUG = true;
+			LOG_LEVEL = log_level::debug;
+		}
+		else if (strcmp(argv[x], "loglevel") == 0) //"loglevel debug", "loglevel info", or "loglevel warning". see log.h
+		{
+			check(x + 1 < argc, "no level after loglevel");
+			string level = argv[++x];
+			if (level == "debug") LOG_LEVEL = log_level::debug;
+			else if (level == "info") LOG_LEVEL = log_level::info;
+			else if (level == "warning") LOG_LEVEL = log_level::warning;
+			else error("unrecognized log level " + level);
+		}
+		else if (strcmp(argv[x], "optimize") == 0) OPTIMIZATION_LEVEL = 2;
+		else if (strcmp(argv[x], "optlevel") == 0) //"optlevel 1". level 0 skips IR passes, 1 promotes allocas and cleans up, 2 adds GVN and friends.
+		{
+			OPTIMIZATION_LEVEL = read_number(x);
+			check(OPTIMIZATION_LEVEL <= 2, "optimization level must be 0, 1, or 2");
+		}
+		else if (strcmp(argv[x], "codegenlevel") == 0) //llvm::CodeGenOpt::Level, from 0 to 3. if not given, it follows optlevel.
+		{
+			CODEGEN_OPT_LEVEL = read_number(x);
+			check(CODEGEN_OPT_LEVEL <= 3, "codegen level must be from 0 to 3");
+		}
+		else if (strcmp(argv[x], "hot") == 0) HOT_THRESHOLD = read_number(x); //"hot 1000" recompiles a function at level 2 after 1000 runs. off by default.
 		else if (strcmp(argv[x], "console") == 0) CONSOLE = true;
 		else if (strcmp(argv[x], "timer") == 0)
 		{
@@ -583,16 +1223,38 @@ int main(int argc, char* argv[])
 		else if (strcmp(argv[x], "oldoutput") == 0) OLD_AST_OUTPUT = true;
 		else if (strcmp(argv[x], "noaddmodule") == 0) DONT_ADD_MODULE_TO_ORC = true;
 		else if (strcmp(argv[x], "deletemodule") == 0) DELETE_MODULE_IMMEDIATELY = true;
+		else if (strcmp(argv[x], "lazy") == 0) LAZY_COMPILE = true;
+		else if (strcmp(argv[x], "crosscheck") == 0) VALIDATOR_CROSSCHECK = true;
+		else if (strcmp(argv[x], "astopt") == 0) AST_OPTIMIZE = true;
+		else if (strcmp(argv[x], "icstats") == 0) INLINE_CACHE_STATS = true;
+		else if (strcmp(argv[x], "profile") == 0) PROFILE_ASTS = true;
+		else if (strcmp(argv[x], "perfmap") == 0) PERF_MAP = true;
+		else if (strcmp(argv[x], "trace") == 0) TRACING = true; //SIGUSR2 toggles it later, and SIGUSR1 dumps. see trace.h
+		else if (strcmp(argv[x], "budget") == 0) //"budget calls", "budget work", or "budget time". see budget_model
+		{
+			check(x + 1 < argc, "no model after budget");
+			string model = argv[++x];
+			if (model == "calls") BUDGET_MODEL = budget_model::calls;
+			else if (model == "work") BUDGET_MODEL = budget_model::work;
+			else if (model == "time") BUDGET_MODEL = budget_model::time;
+			else error("unrecognized budget model " + model);
+		}
+		else if (strcmp(argv[x], "timelimit") == 0) TIME_LIMIT_MICROSECONDS = read_number(x); //microseconds per run, for "budget time"
 		else if (strcmp(argv[x], "truefuzz") == 0) OUTPUT_MODULE = false;
 		else if (strcmp(argv[x], "serialize") == 0) SERIALIZE_ON_EXIT = true;
-		else if (strcmp(argv[x], "file") == 0)
+		else if (strcmp(argv[x], "file") == 0) //the program can be in the text format, or the binary one. see binary_AST.h
 		{
-			string filename = argv[++x];
-			file.open(filename, std::ifstream::in);
+			program_file = argv[++x];
+			file.open(program_file, std::ifstream::in);
 			check(file.is_open() && file.good(), "stream opening failed");
 			TRUERUN = true;
 			FROM_FILE = true;
 		}
+		else if (strcmp(argv[x], "writebinary") == 0) //"file program.txt writebinary program.ast" converts the program to the binary format after loading it.
+		{
+			check(x + 1 < argc, "no file after writebinary");
+			binary_output_file = argv[++x];
+		}
 		else if (strcmp(argv[x], "benchmark") == 0)
 		{
 			runs = 10000;
@@ -600,6 +1262,47 @@ int main(int argc, char* argv[])
 			llvm_console = &llvm_null_stream;
 			BENCHMARK = true;
 		}
+		else if (strcmp(argv[x], "seed") == 0) //"seed 5". makes runs repeatable, by seeding mersenne with a fixed number instead of from std::random_device.
+		{
+			seed = read_number(x);
+			mersenne.seed(seed);
+			seeded = true;
+		}
+		else if (strcmp(argv[x], "benchsuite") == 0) //"benchsuite results.json". see benchmark.h
+		{
+			check(x + 1 < argc, "no file after benchsuite");
+			benchmark_file = argv[++x];
+			QUIET = true;
+			llvm_console = &llvm_null_stream;
+			BENCHMARK = true;
+		}
+		else if (strcmp(argv[x], "record") == 0) //"record session.log". see record_step()
+		{
+			check(x + 1 < argc, "no file after record");
+			session_log.open(argv[++x], std::ofstream::trunc);
+			check(session_log.is_open(), "couldn't open the session log");
+			BENCHMARK = true; //skips the test suite, so that the recording and the replay start from the same heap.
+		}
+		else if (strcmp(argv[x], "replay") == 0) //"replay session.log"
+		{
+			check(x + 1 < argc, "no file after replay");
+			replay_file = argv[++x];
+			QUIET = true;
+			llvm_console = &llvm_null_stream;
+			BENCHMARK = true;
+		}
+		else if (strcmp(argv[x], "farm") == 0) //"farm <worker number> <queue ID> <mmap size>". the admin passes these. see comms.h
+		{
+			uint64_t worker_number = read_number(x);
+			uint64_t queue_ID = read_number(x);
+			join_farm(worker_number, queue_ID, read_number(x));
+			FUZZ_CORPUS_SIZE = 256;
+			QUIET = true;
+			llvm_console = &llvm_null_stream;
+			BENCHMARK = true;
+		}
+		else if (strcmp(argv[x], "guided") == 0) FUZZ_GUIDED = true; //coverage-guided fuzzing. see coverage.h
+		else if (strcmp(argv[x], "corpus") == 0) FUZZ_CORPUS_SIZE = read_number(x); //"corpus 100". the fuzzer keeps this many functions to build on.
 		else if (strcmp(argv[x], "limited") == 0) //write "limited label", where "label" is the AST tag you want. you can have multiple tags like "limited label limited random", putting "limited" before each one.
 		{
 			LIMITED_FUZZ_CHOICES = true;
@@ -638,16 +1341,35 @@ int main(int argc, char* argv[])
 				std::cout << "tag " << x << " " << AST_descriptor[x].name << ' ' << hitcount[x] << '\n';
 			}
 			std::cout << "success rate " << (float)total_successful_compiles/runs << '\n';
+			if (fuzz_CPU_seconds > 0) std::cout << "distinct successful compiles " << distinct_successes.size() << " per CPU second " << distinct_successes.size() / fuzz_CPU_seconds << '\n';
+			if (FUZZ_GUIDED) std::cout << "features " << features_seen << '\n';
+			jit_memory.print_stats();
+			print_inline_cache_stats(INLINE_CACHE_STATS);
+			if (PROFILE_ASTS) print_AST_profile();
+			if (TRACING) write_trace();
 		}
 	} a;
 
+#ifndef NO_CONSOLE
+	if (!benchmark_file.empty())
+	{
+		benchmark_suite(seed, benchmark_file);
+		return 0;
+	}
+	if (!replay_file.empty())
+	{
+		replay_session(replay_file);
+		return 0;
+	}
+#endif
+	if (session_log.is_open()) record_seed(seeded ? seed : mersenne());
+
 	if (TRUERUN)
 	{
 		//load from scratch!
 		if (FROM_FILE)
 		{
-			source_reader k(file, '\\');
-
+			std::unordered_map<string, uAST*> file_objects; //names for the objects the program starts with. they hold pointers, so the binary format refers to them by name too.
 			{
 				svector* static_vector_of_functions = new_vector();
 				uint64_t* pointer_to_vec = new_object_value(static_vector_of_functions);
@@ -655,7 +1377,7 @@ int main(int argc, char* argv[])
 				Tptr Tpointer_vec_func = new_unique_type(Typen("pointer"), Tvector_of_functions);
 				dynobj* imv_vector_of_functions = new_dynamic_obj(Tpointer_vec_func);
 				(*imv_vector_of_functions)[0] = (uint64_t)pointer_to_vec;
-				k.ASTmap.insert({"pointer_to_vec_of_functions", (uAST*)imv_vector_of_functions});
+				file_objects.insert({"pointer_to_vec_of_functions", (uAST*)imv_vector_of_functions});
 			}
 			svector* vector_of_functions = new_vector();
 			uint64_t* pointer_to_function_unit = new_object_value(0, vector_of_functions);
@@ -664,19 +1386,40 @@ int main(int argc, char* argv[])
 			Tptr Tpointerfunc_unit = new_unique_type(Typen("pointer"), Tfuncunit);
 			dynobj* funcunit = new_dynamic_obj(Tpointerfunc_unit);
 			(*funcunit)[0] = (uint64_t)pointer_to_function_unit;
-			k.ASTmap.insert({"func_unit", (uAST*)funcunit});
+			file_objects.insert({"func_unit", (uAST*)funcunit});
 
-			uAST* starting_event_AST = k.read();
+			uAST* starting_event_AST;
+			if (is_binary_AST_file(program_file)) starting_event_AST = load_binary_AST(program_file, file_objects);
+			else
+			{
+				source_reader k(file, '\\');
+				k.ASTmap.insert(file_objects.begin(), file_objects.end());
+				starting_event_AST = k.read();
+			}
+			if (!binary_output_file.empty())
+			{
+				std::unordered_map<uAST*, string> object_names;
+				for (auto& k : file_objects) object_names.insert({k.second, k.first});
+				write_binary_AST(binary_output_file, starting_event_AST, object_names);
+			}
 			function* event_func = compile_returning_just_function(starting_event_AST);
 			check(event_func != 0, "zero function from file");
 			event_roots.push_back(event_func);
 		}
+		//the event loop discards the return value, so it runs the function into a buffer instead of boxing the value.
+		llvm::SmallVector<uint64_t, 4> return_buffer(get_size(event_roots[0]->return_type));
+		uint64_t iterations = 0;
+		uint64_t allocations_at_start = allocation_count;
 		while (1)
 		{
-			finiteness = FINITENESS_LIMIT;
-			run_null_parameter_function(event_roots[0]);
+			start_finiteness_budget();
+			run_function_into(event_roots[0], return_buffer.data());
+			++iterations;
 			if (free_memory_count < pool_size / 10)
+			{
+				if (VERBOSE_GC) print("allocations per iteration: ", (double)(allocation_count - allocations_at_start) / iterations, '\n');
 				start_GC();
+			}
 		}
 	}
 
@@ -685,18 +1428,25 @@ int main(int argc, char* argv[])
 	{
 		while (1)
 		{
-			source_reader k(std::cin, '\n'); //have to reinitialize to clear the ASTmap
 			print("Input AST:\n");
+			flush_log();
+			//the line is read first, so that it can be recorded as typed.
+			string line;
+			std::getline(std::cin, line);
+			std::stringstream line_stream(line + '\n');
+			source_reader k(line_stream, '\n'); //have to reinitialize to clear the ASTmap
 			uAST* end = k.read();
 			if (READER_VERBOSE_DEBUG) print("Done reading.\n");
 			if (end == nullptr)
 			{
-				print("it's nullptr\n");
-				std::cin.get();
+				print_at(log_level::warning, "it's nullptr\n");
 				continue;
 			}
+			//only once it parses, so that replay doesn't trip over it.
+			record_step();
+			if (session_log.is_open()) session_log << line << '\n';
 			pfAST(end);
-			finiteness = FINITENESS_LIMIT;
+			start_finiteness_budget();
 			uint64_t compile_result[3];
 			compile_returning_legitimate_object(compile_result, end);
 			dynobj* run_result = run_null_parameter_function((function*)compile_result[0]); //even if it's 0, it's fine.
@@ -705,7 +1455,10 @@ int main(int argc, char* argv[])
 			else if (run_result) output_array(&(*run_result)[0], get_size(run_result->type));
 
 			if ((generate_random() % (GC_TIGHT ? 1 : 30)) == 0)
+			{
+				record_GC();
 				start_GC();
+			}
 		}
 	}
 #endif
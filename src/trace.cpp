@@ -0,0 +1,114 @@
+#include <array>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "trace.h"
+#include "utility.h"
+
+std::atomic<bool> TRACING(false);
+static volatile std::sig_atomic_t trace_dump_requested = 0;
+static const std::chrono::steady_clock::time_point trace_epoch = std::chrono::steady_clock::now();
+
+namespace
+{
+struct trace_event
+{
+	const char* name;
+	uint64_t start;
+	uint64_t duration;
+};
+struct trace_buffer
+{
+	std::array<trace_event, trace_buffer_size> events;
+	std::atomic<uint64_t> next{0}; //how many events were ever written. the newest is at (next - 1) % trace_buffer_size.
+	uint64_t thread_number;
+};
+}
+
+static std::vector<trace_buffer*>& trace_buffers()
+{
+	static never_destroyed<std::vector<trace_buffer*>> buffers;
+	return buffers.get();
+}
+static std::mutex& trace_buffers_lock() //only for registering a thread, and for dumping.
+{
+	static never_destroyed<std::mutex> lock;
+	return lock.get();
+}
+static thread_local trace_buffer* this_thread_trace = nullptr;
+
+uint64_t trace_now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - trace_epoch).count() + 1;
+}
+
+void end_trace_span(const char* name, uint64_t start)
+{
+	uint64_t end = trace_now();
+	if (this_thread_trace == nullptr)
+	{
+		this_thread_trace = new trace_buffer;
+		std::lock_guard<std::mutex> guard(trace_buffers_lock());
+		this_thread_trace->thread_number = trace_buffers().size();
+		trace_buffers().push_back(this_thread_trace);
+	}
+	uint64_t n = this_thread_trace->next.load(std::memory_order_relaxed);
+	this_thread_trace->events[n % trace_buffer_size] = {name, start, end - start};
+	this_thread_trace->next.store(n + 1, std::memory_order_release);
+
+	if (trace_dump_requested)
+	{
+		trace_dump_requested = 0;
+		write_trace();
+	}
+}
+
+static void trace_signal_handler(int signal)
+{
+	if (signal == SIGUSR1) trace_dump_requested = 1;
+	else if (signal == SIGUSR2) TRACING.store(!TRACING.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+void install_trace_signals()
+{
+	std::signal(SIGUSR1, trace_signal_handler);
+	std::signal(SIGUSR2, trace_signal_handler);
+}
+
+//the "X" phase is a complete event: a start and a duration. times are in microseconds.
+void write_trace()
+{
+	std::ofstream output("trace-" + std::to_string(getpid()) + ".json", std::ofstream::trunc);
+	output << "{\"traceEvents\":[";
+	bool first = true;
+	std::lock_guard<std::mutex> guard(trace_buffers_lock());
+	for (trace_buffer* buffer : trace_buffers())
+	{
+		uint64_t end = buffer->next.load(std::memory_order_acquire);
+		uint64_t begin = end > trace_buffer_size ? end - trace_buffer_size : 0;
+		for (uint64_t x = begin; x < end; ++x)
+		{
+			const trace_event& e = buffer->events[x % trace_buffer_size];
+			output << (first ? "\n" : ",\n") << "{\"name\":\"" << e.name << "\",\"ph\":\"X\",\"pid\":" << getpid() << ",\"tid\":" << buffer->thread_number
+				<< ",\"ts\":" << e.start / 1000.0 << ",\"dur\":" << e.duration / 1000.0 << '}';
+			first = false;
+		}
+	}
+	output << "\n]}\n";
+}
+
+uint64_t count_traced_spans(const char* name)
+{
+	if (this_thread_trace == nullptr) return 0;
+	uint64_t end = this_thread_trace->next.load(std::memory_order_relaxed);
+	uint64_t begin = end > trace_buffer_size ? end - trace_buffer_size : 0;
+	uint64_t count = 0;
+	for (uint64_t x = begin; x < end; ++x)
+		count += strcmp(this_thread_trace->events[x % trace_buffer_size].name, name) == 0;
+	return count;
+}
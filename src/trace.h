@@ -0,0 +1,29 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+/* event tracing, for timelines instead of totals. a trace_span records when it starts and ends, into its thread's ring buffer, which keeps the newest trace_buffer_size spans.
+each buffer has one writer, its own thread, so recording doesn't lock. buffers are created on a thread's first span, and never freed, so a dump can read them after their thread ends.
+spans are only recorded while TRACING is on. the "trace" flag turns it on, and SIGUSR2 toggles it while running.
+the spans are written as Chrome trace JSON (chrome://tracing, or Perfetto) to trace-<pid>.json at exit if tracing is on, and when SIGUSR1 asks.
+a signal handler can't safely write a file, so SIGUSR1 only sets a flag, and the file is written when the next span ends.
+with tracing off, a span costs a load and a branch.
+*/
+extern std::atomic<bool> TRACING; //atomic, because the signal handler writes it.
+constexpr uint64_t trace_buffer_size = 1 << 16;
+
+uint64_t trace_now(); //nanoseconds since startup, plus 1, so that 0 means "not recording".
+void end_trace_span(const char* name, uint64_t start);
+
+//name must be a string literal, or otherwise outlive the trace. the buffer only keeps the pointer.
+struct trace_span
+{
+	const char* name;
+	uint64_t start;
+	trace_span(const char* n) : name(n), start(TRACING.load(std::memory_order_relaxed) ? trace_now() : 0) {}
+	~trace_span() { if (start) end_trace_span(name, start); }
+};
+
+void install_trace_signals();
+void write_trace(); //to trace-<pid>.json
+uint64_t count_traced_spans(const char* name); //in this thread's buffer. for the test suite.
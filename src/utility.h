@@ -0,0 +1,17 @@
+#pragma once
+#include <cstdint>
+#include <new>
+
+//FNV-1a, a word at a time. start from fnv_offset_basis.
+constexpr uint64_t fnv_offset_basis = 0xcbf29ce484222325ull;
+inline uint64_t hash_combine(uint64_t h, uint64_t word) { return (h ^ word) * 0x100000001b3ull; }
+
+//for globals that are still used during exit. modules are destroyed after the globals of most files, and flushing or tracing can happen from atexit handlers.
+//a function-local never_destroyed is built on first use, and its destructor does nothing, so it outlives every static destructor.
+template <class T> class never_destroyed
+{
+	alignas(T) unsigned char storage[sizeof(T)];
+public:
+	never_destroyed() { new (storage) T; }
+	T& get() { return *reinterpret_cast<T*>(storage); }
+};
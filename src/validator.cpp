@@ -0,0 +1,498 @@
+#include "validator.h"
+#include "vector.h"
+#include "cs11.h"
+#include "coverage.h"
+
+void AST_validator::new_living_object(uAST* target, const abstract_info& r)
+{
+	if (!objects.insert({target, r}).second) //collision: AST is already there
+		return;
+	object_stack.push_back(target);
+}
+
+void AST_validator::clear_stack(uint64_t desired_stack_size)
+{
+	while (object_stack.size() > desired_stack_size) //>, because desired_stack_size might be ~0ull
+	{
+		objects.erase(object_stack.back());
+		object_stack.pop_back();
+	}
+}
+
+//IRBuilder folds extractvalue/insertvalue on constants, so a concatenation is a constant iff all its words are.
+//if a part is missing, its words are undef. then, the result is a Constant but not a ConstantInt, so we just call it a variable.
+static abstract_value concatenate_values(const abstract_value& first, const abstract_value& second, uint64_t total_size)
+{
+	abstract_value result = abstract_value::variable();
+	result.is_constant = true;
+	for (auto* part : {&first, &second})
+	{
+		if (!part->exists) continue;
+		if (!part->is_constant) return abstract_value::variable();
+		result.words.append(part->words.begin(), part->words.end());
+	}
+	if (result.words.size() != total_size) return abstract_value::variable();
+	return result;
+}
+
+//mirrors llvm_create_phi(): a missing value is skipped, and a single remaining value passes through unchanged.
+static abstract_value phi_values(const abstract_value& first, const abstract_value& second)
+{
+	if (!first.exists) return second;
+	if (!second.exists) return first;
+	return abstract_value::variable();
+}
+
+//mirrors generate_IR(). the comments there explain why each check exists; this only explains where the two differ.
+abstract_info AST_validator::validate(uAST* target, uint64_t stack_degree)
+{
+	check(stack_degree != 1, "no more stack degree 1");
+	if (target == nullptr) return abstract_info();
+
+	uint64_t final_stack_position = ~0ull;
+	bool default_allocation = false;
+	llvm::SmallVector<abstract_info, 4> field_results;
+
+	//field_type is for the coverage feature. it's the field's type, if the field was validated.
+	auto reject = [&](IRgen_status code, uint64_t field, Tptr field_type = 0) -> abstract_info
+	{
+		if (field_type == 0 && field < field_results.size()) field_type = field_results[field].type;
+		record_feature(feature_kind::error, target->tag << 32 | field, code, feature_of_type(field_type));
+		error_location = target;
+		error_field = field;
+		abstract_info r(abstract_value::none(), u::null);
+		r.error_code = code;
+		return r;
+	};
+
+	//mirrors finish_internal(). default_hidden_subtype is always nullptr there, so results never have a hidden subtype.
+	auto finish_special = [&](abstract_value return_value, Tptr type) -> abstract_info
+	{
+		if (types) types->record(target, type);
+		record_feature(feature_kind::compiled, target->tag, feature_of_type(type));
+		bool existing_hidden_location = default_allocation;
+		if (stack_degree == 2) clear_stack(final_stack_position);
+		uint64_t size_of_return = get_size(type);
+		if (size_of_return >= 1 && (stack_degree == 2 || default_allocation))
+		{
+			abstract_info r = abstract_info::at_place(type, existing_hidden_location);
+			new_living_object(target, r);
+			return r;
+		}
+		else if (size_of_return >= 1)
+		{
+			abstract_info r(return_value, type);
+			new_living_object(target, r);
+			return r;
+		}
+		else return abstract_info();
+	};
+	auto finish = [&](abstract_value return_value) -> abstract_info
+	{
+		check(AST_descriptor[target->tag].return_object.state != special_return, "need to specify type");
+		return finish_special(return_value, uniquefy_premade_type(AST_descriptor[target->tag].return_object.type, true));
+	};
+	auto field_constant = [&](uint64_t x) { return field_results[x].IR.is_ConstantInt(); };
+	auto field_word = [&](uint64_t x) { return field_results[x].IR.words[0]; };
+
+	auto looking_for_reference = objects.find(target);
+	if (looking_for_reference != objects.end())
+	{
+		abstract_info refreshed_load = looking_for_reference->second;
+		if (refreshed_load.place) refreshed_load.IR = abstract_value::variable();
+		return refreshed_load;
+	}
+
+	if (loop_catcher.insert(target).second == false) return reject(IRgen_status::infinite_loop, 10);
+	struct loop_catcher_destructor_cleanup
+	{
+		AST_validator* object; uAST* targ;
+		loop_catcher_destructor_cleanup(AST_validator* x, uAST* t) : object(x), targ(t) {}
+		~loop_catcher_destructor_cleanup() { object->loop_catcher.erase(targ); }
+	} temp_object(this, target);
+
+	final_stack_position = object_stack.size();
+
+	for (uint64_t x = 0; x < AST_descriptor[target->tag].fields_to_compile; ++x)
+	{
+		abstract_info result;
+		if (target->fields[x])
+		{
+			result = validate(target->fields[x]);
+			if (result.error_code) return result;
+		}
+		if (uniquefy_premade_type(AST_descriptor[target->tag].parameter_types[x].type, true) == u::does_not_return)
+			return finish_special(abstract_value::none(), u::does_not_return);
+		if (AST_descriptor[target->tag].parameter_types[x].state != compile_without_type_check)
+		{
+			if (type_check(RVO, result.type, uniquefy_premade_type(AST_descriptor[target->tag].parameter_types[x].type, true)) != type_check_result::perfect_fit) return reject(IRgen_status::type_mismatch, x, result.type);
+		}
+		field_results.push_back(result);
+	}
+
+	switch (target->tag)
+	{
+	case ASTn("basicblock"):
+		{
+			svector* k = (svector*)target->fields[0];
+			abstract_info final;
+			for (uint64_t& AST : Vector_range(k))
+			{
+				final = validate((uAST*)AST, 2);
+				if (final.error_code) return final;
+			}
+			if (stack_degree == 0 && final.place) final.IR = abstract_value::variable();
+			if (types) types->record(target, final.type);
+			return final;
+		}
+	case ASTn("zero"): return finish(abstract_value::constant(0));
+	case ASTn("increment"): return finish(field_constant(0) ? abstract_value::constant(field_word(0) + 1) : abstract_value::variable());
+	case ASTn("decrement"): return finish(field_constant(0) ? abstract_value::constant(field_word(0) - 1) : abstract_value::variable());
+	case ASTn("add"): return finish(field_constant(0) && field_constant(1) ? abstract_value::constant(field_word(0) + field_word(1)) : abstract_value::variable());
+	case ASTn("subtract"): return finish(field_constant(0) && field_constant(1) ? abstract_value::constant(field_word(0) - field_word(1)) : abstract_value::variable());
+	case ASTn("multiply"): return finish(field_constant(0) && field_constant(1) ? abstract_value::constant(field_word(0) * field_word(1)) : abstract_value::variable());
+	case ASTn("lessu"): return finish(field_constant(0) && field_constant(1) ? abstract_value::constant(field_word(0) < field_word(1)) : abstract_value::variable());
+	case ASTn("lesss"): return finish(field_constant(0) && field_constant(1) ? abstract_value::constant((int64_t)field_word(0) < (int64_t)field_word(1)) : abstract_value::variable());
+	case ASTn("random"):
+	case ASTn("udiv"): //these become phis in generate_IR, which are never folded.
+	case ASTn("urem"):
+	case ASTn("ushr"):
+	case ASTn("sshr"):
+	case ASTn("shl"):
+		return finish(abstract_value::variable());
+	case ASTn("if"):
+		{
+			uint64_t if_stack_position = object_stack.size();
+			abstract_info case_IR[2];
+			for (uint64_t x : {0, 1})
+			{
+				case_IR[x] = validate(target->fields[x + 1]);
+				if (case_IR[x].error_code) return case_IR[x];
+				clear_stack(if_stack_position);
+			}
+
+			Tptr result_type = case_IR[0].type;
+			if (type_check(RVO, case_IR[1].type, case_IR[0].type) != type_check_result::perfect_fit)
+			{
+				result_type = case_IR[1].type;
+				if (type_check(RVO, case_IR[0].type, case_IR[1].type) != type_check_result::perfect_fit)
+				{
+					result_type = u::null;
+				}
+			}
+			if (result_type) return finish_special(phi_values(case_IR[0].IR, case_IR[1].IR), result_type);
+			else return finish_special(abstract_value::none(), u::null);
+		}
+	case ASTn("nvec"):
+		if (field_constant(0))
+		{
+			Tptr type = field_word(0);
+			if (type == 0) return reject(IRgen_status::type_mismatch, 0);
+			if (type.ver() == 0) return reject(IRgen_status::vector_cant_take_large_objects, 0);
+
+			if (!is_full(type)) return reject(IRgen_status::nonfull_object, 0);
+			else if (type.ver() > Typen("pointer")) return reject(IRgen_status::type_mismatch, 0);
+			else if (get_size(type) != 1) return reject(IRgen_status::type_mismatch, 0);
+			return finish_special(abstract_value::variable(), new_unique_type(Typen("vector"), type));
+		}
+		return reject(IRgen_status::requires_constant, 1);
+
+	case ASTn("label"):
+		{
+			if (label_is_forward.insert({target, true}).second == false)
+				return reject(IRgen_status::label_duplication, 0);
+
+			abstract_info scoped = validate(target->fields[0]);
+			if (scoped.error_code) return scoped;
+
+			label_is_forward.find(target)->second = false;
+			return finish(abstract_value::none());
+		}
+	case ASTn("goto"):
+		{
+			auto labelsearch = label_is_forward.find(target->fields[0]);
+			if (labelsearch == label_is_forward.end()) return reject(IRgen_status::missing_label, 0);
+			if (labelsearch->second) return finish_special(abstract_value::none(), u::does_not_return);
+			return finish(abstract_value::none());
+		}
+	case ASTn("pointer"):
+		{
+			auto found_AST = objects.find(target->fields[0]);
+			if (found_AST == objects.end()) return reject(IRgen_status::pointer_without_target, 0);
+			if (!found_AST->second.place) return reject(IRgen_status::pointer_to_temporary, 0);
+			Tptr new_pointer_type(0);
+			if (found_AST->second.hidden_reference == true || !is_full(found_AST->second.type))
+				new_pointer_type = new_unique_type(Typen("temp pointer"), found_AST->second.type);
+			else new_pointer_type = new_unique_type(Typen("pointer"), found_AST->second.type);
+			return finish_special(abstract_value::variable(), new_pointer_type);
+		}
+	case ASTn("tmp_pointer"):
+		{
+			if (field_results[0].type.ver() != Typen("pointer")) return reject(IRgen_status::type_mismatch, 0);
+			return finish_special(field_results[0].IR, new_unique_type(Typen("temp pointer"), field_results[0].type.field(0)));
+		}
+	case ASTn("concatenate"):
+		{
+			uint64_t total_size = get_size(field_results[0].type) + get_size(field_results[1].type);
+			if (total_size == 0) return finish_special(abstract_value::none(), u::null);
+			abstract_value final_value = concatenate_values(field_results[0].IR, field_results[1].IR, total_size);
+			return finish_special(final_value, concatenate_types({field_results[0].type, field_results[1].type}));
+		}
+	case ASTn("store"):
+		{
+			if (field_results[0].type == 0) return reject(IRgen_status::type_mismatch, 0);
+			if (type_check(RVO, field_results[1].type, field_results[0].type) == type_check_result::perfect_fit)
+			{
+				if (!field_results[0].place) return reject(IRgen_status::missing_reference, 0);
+				return finish(abstract_value::none());
+			}
+			if (field_results[0].type.ver() == Typen("temp pointer") || field_results[0].type.ver() == Typen("pointer"))
+			{
+				if (type_check(RVO, field_results[1].type, field_results[0].type.field(0)) == type_check_result::perfect_fit)
+					return finish(abstract_value::none());
+			}
+			return reject(IRgen_status::type_mismatch, 1);
+		}
+	case ASTn("try_store"):
+		{
+			if (field_results[0].type == 0) return reject(IRgen_status::type_mismatch, 0);
+			if (!field_results[0].place) return reject(IRgen_status::missing_reference, 0);
+
+			for (uint64_t x : {0, 1})
+			{
+				if (field_results[x].type.ver() == Typen("pointer to something") ||
+					field_results[x].type.ver() == Typen("vector of something"))
+					if (!field_results[x].hidden_subtype) return reject(IRgen_status::lost_hidden_subtype, x);
+			}
+
+			switch (field_results[0].type.ver())
+			{
+			case Typen("pointer"):
+				if (field_results[1].type != Typen("pointer to something")) return reject(IRgen_status::type_mismatch, 1);
+				break;
+			case Typen("vector"):
+				if (field_results[1].type != Typen("vector of something")) return reject(IRgen_status::type_mismatch, 1);
+				break;
+			case Typen("vector of something"):
+				if (field_results[1].type != Typen("vector of something") && field_results[1].type.ver() != Typen("vector")) return reject(IRgen_status::type_mismatch, 1);
+				break;
+			case Typen("pointer to something"):
+				if (field_results[1].type != Typen("pointer to something") && field_results[1].type.ver() != Typen("pointer")) return reject(IRgen_status::type_mismatch, 1);
+				break;
+			default:
+				return reject(IRgen_status::type_mismatch, 0);
+			}
+
+			for (int x : {0, 1})
+			{
+				switch (field_results[x].type.ver())
+				{
+				case Typen("pointer"):
+				case Typen("vector"):
+				case Typen("vector of something"):
+				case Typen("pointer to something"):
+					break;
+				default:
+					return reject(IRgen_status::type_mismatch, 0);
+				}
+			}
+			return finish(abstract_value::variable());
+		}
+	case ASTn("dyn_subobj"):
+		{
+			if (type_check(RVO, field_results[0].type, u::dynamic_object) != type_check_result::perfect_fit)
+			{
+				if (!field_results[0].hidden_subtype) return reject(IRgen_status::lost_hidden_subtype, 0);
+				if (field_results[0].type != u::pointer_to_something && field_results[0].type != u::vector_of_something)
+					return reject(IRgen_status::type_mismatch, 0);
+			}
+
+			uint64_t starting_stack_position = object_stack.size();
+			for (uint64_t x = 0; x <= Typen("pointer"); ++x)
+			{
+				if (x != 0)
+				{
+					if (x == Typen("pointer")) new_living_object(target, abstract_info::at_place(Typen("pointer to something"), true, true));
+					else if (x == Typen("vector")) new_living_object(target, abstract_info::at_place(Typen("vector of something"), true, true));
+					else new_living_object(target, abstract_info::at_place((Tptr)x, true));
+				}
+				abstract_info case_IR = validate(target->fields[x + 2]);
+				if (case_IR.error_code) return case_IR;
+
+				clear_stack(starting_stack_position);
+			}
+			return finish(abstract_value::variable());
+		}
+	case ASTn("load_subobj_ref"):
+		{
+			Tptr type_of_object(0);
+			switch (field_results[0].type.ver())
+			{
+			case Typen("vector"): type_of_object = field_results[0].type.field(0); break;
+			case Typen("AST pointer"): type_of_object = u::AST_pointer; break;
+			default: return reject(IRgen_status::type_mismatch, 0);
+			}
+
+			abstract_info case_IR;
+			uint64_t starting_stack_position = object_stack.size();
+			new_living_object(target, abstract_info::at_place(type_of_object, true));
+			case_IR = validate(target->fields[2]);
+			if (case_IR.error_code) return case_IR;
+			clear_stack(starting_stack_position);
+			return finish(abstract_value::none());
+		}
+	case ASTn("vecpb"):
+		{
+			if (!field_results[0].place) return reject(IRgen_status::missing_reference, 0);
+			if (field_results[0].type.ver() != Typen("vector")) return reject(IRgen_status::type_mismatch, 0);
+			if (type_check(RVO, field_results[1].type, field_results[0].type.field(0)) != type_check_result::perfect_fit) return reject(IRgen_status::type_mismatch, 1);
+			return finish(abstract_value::none());
+		}
+	case ASTn("vecsz"):
+		{
+			if (field_results[0].type.ver() == Typen("vector") || field_results[0].type.ver() == Typen("vector of something"))
+				return finish(abstract_value::variable());
+			return reject(IRgen_status::type_mismatch, 0);
+		}
+	case ASTn("dynamify"):
+		{
+			if (field_results[0].type == 0)
+				return finish(abstract_value::constant(0));
+			if (!is_full(field_results[0].type))
+				return reject(IRgen_status::nonfull_object, 0);
+			return finish(abstract_value::variable());
+		}
+	case ASTn("compile"):
+		{
+			if (type_check(RVO, field_results[0].type, T::null) == type_check_result::perfect_fit) return finish(abstract_value::constant(0));
+			else if (type_check(RVO, field_results[0].type, T::AST_pointer) == type_check_result::perfect_fit) return finish(abstract_value::variable());
+			else return reject(IRgen_status::type_mismatch, 0);
+		}
+	case ASTn("convert_to_AST"):
+		{
+			if (field_results[1].type == T::null) return finish(abstract_value::variable());
+			if (type_check(RVO, field_results[1].type, u::vector_of_ASTs) != type_check_result::perfect_fit)
+				return reject(IRgen_status::type_mismatch, 1);
+			return finish(abstract_value::variable());
+		}
+	case ASTn("overfunc"):
+	case ASTn("imv_AST"):
+	case ASTn("run_function"):
+	case ASTn("run_function_with"):
+	case ASTn("system1"):
+	case ASTn("system2"):
+	case ASTn("agency1"):
+	case ASTn("agency2"):
+		return finish(abstract_value::variable());
+	case ASTn("load_tag"):
+		{
+			Tptr type_of_pointer = field_results[0].type;
+			if (type_of_pointer == 0) return reject(IRgen_status::type_mismatch, 0);
+			switch (type_of_pointer.ver())
+			{
+			case Typen("type pointer"):
+			case Typen("AST pointer"):
+				return finish(abstract_value::variable());
+			default: return reject(IRgen_status::type_mismatch, 0);
+			}
+		}
+	case ASTn("load_imv_from_AST"):
+	case ASTn("load_vector_from_BB"):
+		{
+			abstract_info case_IR;
+			uint64_t starting_stack_position = object_stack.size();
+			new_living_object(target, abstract_info::at_place(target->tag == ASTn("load_imv_from_AST") ? u::dynamic_object : u::vector_of_ASTs, true));
+			case_IR = validate(target->fields[1]);
+			if (case_IR.error_code) return case_IR;
+			clear_stack(starting_stack_position);
+			return finish(abstract_value::none());
+		}
+	case ASTn("imv"):
+		{
+			uint64_t* dynamic_object = (uint64_t*)target->fields[0];
+			if (dynamic_object == nullptr)
+				return finish_special(abstract_value::none(), 0);
+			Tptr type_of_object = *(Tptr*)dynamic_object;
+			uint64_t* array_of_integers = (uint64_t*)(dynamic_object + 1);
+			uint64_t size_of_object = get_size(type_of_object);
+			if (size_of_object)
+			{
+				abstract_value object = abstract_value::variable();
+				object.is_constant = true;
+				object.words.append(array_of_integers, array_of_integers + size_of_object);
+				return finish_special(object, type_of_object);
+			}
+			else return finish_special(abstract_value::none(), 0);
+		}
+	case ASTn("load_subobj"):
+		{
+			Tptr type_of_pointer = field_results[0].type;
+			if (type_of_pointer == 0) return reject(IRgen_status::type_mismatch, 0);
+			switch (type_of_pointer.ver())
+			{
+			case Typen("pointer"):
+			case Typen("temp pointer"):
+				if (field_constant(1))
+				{
+					Tptr offset_type = get_offset_type(type_of_pointer.field(0), field_word(1));
+					if (offset_type == 0) return reject(IRgen_status::oversized_offset, 1);
+					default_allocation = true;
+					return finish_special(abstract_value::variable(), offset_type);
+				}
+				return reject(IRgen_status::requires_constant, 1);
+			case Typen("type pointer"):
+				return finish_special(abstract_value::variable(), u::type);
+			case Typen("AST pointer"):
+				return finish_special(abstract_value::variable(), u::AST_pointer);
+			case Typen("vector"):
+				if (!is_zeroable(field_results[0].type.field(0))) return reject(IRgen_status::type_mismatch, 0);
+				return finish_special(abstract_value::variable(), field_results[0].type.field(0));
+			case Typen("function pointer"):
+				if (field_constant(1))
+				{
+					uint64_t offset = field_word(1);
+					if (offset == 0) return finish_special(abstract_value::variable(), u::AST_pointer);
+					else if (offset == 1) return finish_special(abstract_value::variable(), u::type);
+					else return reject(IRgen_status::oversized_offset, 1);
+				}
+				return reject(IRgen_status::requires_constant, 1);
+			case Typen("con_vec"):
+				if (field_constant(1))
+				{
+					uint64_t offset = field_word(1);
+					Tptr offset_type = get_offset_type(type_of_pointer, offset);
+					if (offset_type == 0) return reject(IRgen_status::oversized_offset, 1);
+					if (field_results[0].place)
+					{
+						default_allocation = true;
+						return finish_special(abstract_value::variable(), offset_type);
+					}
+					//extractvalue on a constant aggregate is folded.
+					const abstract_value& whole = field_results[0].IR;
+					if (whole.is_constant && offset < whole.words.size()) return finish_special(abstract_value::constant(whole.words[offset]), offset_type);
+					return finish_special(abstract_value::variable(), offset_type);
+				}
+				return reject(IRgen_status::requires_constant, 1);
+			default:
+				return reject(IRgen_status::type_mismatch, 0);
+			}
+		}
+	case ASTn("parameter"):
+		{
+			if (!field_constant(0)) return reject(IRgen_status::requires_constant, 0);
+			Tptr parameter_type = field_word(0);
+			uint64_t size = get_size(parameter_type);
+			if (size == 0) return reject(IRgen_status::type_mismatch, 0);
+			if (parameter_words + size > max_parameter_words) return reject(IRgen_status::too_many_parameters, 0);
+			parameter_words += size;
+			default_allocation = true;
+			return finish_special(abstract_value::variable(), parameter_type);
+		}
+	case ASTn("typeof"): return finish(abstract_value::constant(field_results[0].type));
+	case ASTn("get_event_loop"): return finish(abstract_value::constant((uint64_t)event_roots.at(0)));
+	case ASTn("optimize"): return finish(abstract_value::variable());
+	default:
+		error("no switch");
+	}
+	error("fell through switches");
+}
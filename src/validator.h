@@ -0,0 +1,92 @@
+#pragma once
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/SmallPtrSet.h>
+#include <llvm/ADT/SmallVector.h>
+#include "types.h"
+#include "ASTs.h"
+#include "helperfunctions.h"
+
+/* AST_validator runs the same checks as generate_IR(), but without touching LLVM. compile_AST() runs it first, so that malformed ASTs are rejected before any Module or IR exists.
+it must produce exactly the same error codes, error locations, and return types as generate_IR(). so it mirrors generate_IR() case by case, and if you change one, change the other.
+in "crosscheck" mode, compile_AST() runs both and checks that they agree.
+
+instead of llvm::Values, it tracks what generate_IR() needs to know about them:
+	whether the Value exists at all, since phi creation and concatenate skip missing values.
+	whether it's an llvm::Constant, and what its words are. IRBuilder folds operations on constants, and some ASTs (nvec, load_subobj) require a ConstantInt field.
+instead of memory_allocations, it only tracks whether there is a place.
+*/
+struct abstract_value
+{
+	bool exists = false;
+	bool is_constant = false;
+	llvm::SmallVector<uint64_t, 2> words; //only meaningful if is_constant
+
+	static abstract_value none() { return abstract_value(); }
+	static abstract_value variable() { abstract_value v; v.exists = true; return v; }
+	static abstract_value constant(uint64_t x) { abstract_value v; v.exists = true; v.is_constant = true; v.words.push_back(x); return v; }
+	bool is_ConstantInt() const { return is_constant && words.size() == 1; }
+};
+
+//mirrors Return_Info.
+struct abstract_info
+{
+	IRgen_status error_code = IRgen_status::no_error;
+	abstract_value IR;
+	bool place = false;
+	Tptr type = T::null;
+	bool hidden_reference = false;
+	bool hidden_subtype = false;
+
+	abstract_info() {}
+	abstract_info(abstract_value v, Tptr t) : IR(v), type(t) {}
+	//mirrors the Return_Info constructor that takes a memory_allocation. if it's a hidden reference, the IR is a load.
+	static abstract_info at_place(Tptr t, bool h, bool hs = false)
+	{
+		abstract_info r(h ? abstract_value::variable() : abstract_value::none(), t);
+		r.place = true;
+		r.hidden_reference = h;
+		r.hidden_subtype = hs;
+		return r;
+	}
+};
+
+//the type each AST produced during validation. the AST optimizer uses this to check that its rewrites keep types.
+//an AST that's compiled more than once, with different types, has no single type.
+struct AST_type_record
+{
+	llvm::DenseMap<uAST*, Tptr> types;
+	llvm::SmallPtrSet<uAST*, 8> ambiguous;
+
+	void record(uAST* target, Tptr type)
+	{
+		auto insertion = types.insert({target, type});
+		if (!insertion.second && insertion.first->second != type) ambiguous.insert(target);
+	}
+	bool find(uAST* target, Tptr& type) const
+	{
+		auto found = types.find(target);
+		if (found == types.end() || ambiguous.count(target)) return false;
+		type = found->second;
+		return true;
+	}
+};
+
+class AST_validator
+{
+	llvm::SmallPtrSet<uAST*, 32> loop_catcher;
+	llvm::SmallVector<uAST*, 32> object_stack;
+	llvm::SmallDenseMap<uAST*, abstract_info, 16> objects;
+	llvm::SmallDenseMap<uAST*, bool, 4> label_is_forward; //goto only needs to know which direction the label is.
+	uint64_t parameter_words = 0; //for the too_many_parameters check.
+
+	void new_living_object(uAST* target, const abstract_info& r);
+	void clear_stack(uint64_t desired_stack_size);
+public:
+	abstract_info validate(uAST* target, uint64_t stack_degree = 0);
+
+	//exists when there's an error, same as in compiler_object.
+	uAST* error_location = nullptr;
+	uint64_t error_field = 0;
+
+	AST_type_record* types = nullptr; //if set, validate() records each AST's type here.
+};
@@ -1,5 +1,7 @@
 #include <chrono>
+#include <cstring>
 #include <unistd.h>
+#include <sys/wait.h>
 #include <sys/mman.h>
 #include <sys/types.h>
 #include <sys/stat.h>        /* For mode constants */
@@ -18,6 +20,8 @@ multiple_sender_queue admin_receiver;
 std::vector<std::chrono::steady_clock::time_point> time_of_last_ping;
 std::vector<bool> pinged_already;
 std::vector<pid_t> user_PIDs;
+std::vector<uint64_t> farm_iterations; //for each farm worker, its latest report.
+std::vector<std::vector<uint64_t>> farm_hitcounts;
 
 //call only when it is already known that an event must be processed
 void admin_handle_event()
@@ -32,13 +36,101 @@ void admin_handle_event()
 			pinged_already[citizen_ID] = false;
 			break;
 		}
+	case farm_stats:
+		{
+			uint64_t worker = admin_receiver.get_next_value();
+			farm_iterations.at(worker) = admin_receiver.get_next_value();
+			farm_hitcounts[worker].resize(admin_receiver.get_next_value());
+			for (auto& count : farm_hitcounts[worker])
+				count = admin_receiver.get_next_value();
+			break;
+		}
 	default:
 		error("unknown event enum");
 		break;
 	}
 }
 
-int main() {
+/* farm mode: "admin farm N" runs N fuzzing workers, which are the backend binary, "toy". see comms.h in the backend.
+the workers send each other ASTs directly. the admin only sums up their reports, and prints them every second.
+*/
+int run_farm(uint64_t number_of_workers)
+{
+	mmap_size = 1024 * 1024; //1 MB, since shared ASTs are much bigger than the control messages.
+	std::random_device random;
+	std::vector<uint64_t> id_list;
+	std::vector<void*> mmap_list;
+	for (uint64_t x = 0; x <= number_of_workers; ++x) //the last one is the admin's.
+	{
+		id_list.push_back(random() + ((uint64_t)random() << 32));
+		mmap_list.push_back(allocate_shm(id_list[x]));
+		multiple_sender_queue(mmap_list[x]).initialize();
+	}
+	admin_receiver.memory_location = (std::atomic<uint64_t>*)(mmap_list[number_of_workers]);
+	farm_iterations.assign(number_of_workers, 0);
+	farm_hitcounts.assign(number_of_workers, {});
+
+	for (uint64_t x = 0; x < number_of_workers; ++x)
+	{
+		multiple_sender_queue worker_receiver(mmap_list[x]);
+		worker_receiver.write_values({events::file_ID_of_admin, id_list[number_of_workers]});
+		for (uint64_t y = 0; y < number_of_workers; ++y)
+			if (y != x) worker_receiver.write_values({events::file_ID_of_user, y, id_list[y]});
+
+		pid_t child_pid = fork();
+		if (child_pid == 0)
+		{
+			execl("toy", "toy", "farm", std::to_string(x).c_str(), std::to_string(id_list[x]).c_str(), std::to_string(mmap_size).c_str(), nullptr);
+			error("couldn't exec the farm worker"); //execl only returns on failure
+		}
+		check(child_pid != -1, "fork failed");
+		user_PIDs.push_back(child_pid);
+	}
+
+	uint64_t living_workers = number_of_workers;
+	uint64_t previous_total = 0;
+	auto previous_time = std::chrono::steady_clock::now();
+	while (living_workers)
+	{
+		while (admin_receiver.should_I_load()) admin_handle_event();
+		int status;
+		while (waitpid(-1, &status, WNOHANG) > 0)
+		{
+			std::cerr << "a farm worker exited\n";
+			--living_workers;
+		}
+
+		auto current_time = std::chrono::steady_clock::now();
+		double seconds = std::chrono::duration_cast<std::chrono::duration<double>>(current_time - previous_time).count();
+		if (seconds >= 1)
+		{
+			uint64_t total = 0;
+			for (uint64_t iterations : farm_iterations) total += iterations;
+			std::vector<uint64_t> total_hitcount;
+			for (auto& hitcount : farm_hitcounts)
+			{
+				if (hitcount.size() > total_hitcount.size()) total_hitcount.resize(hitcount.size());
+				for (uint64_t tag = 0; tag < hitcount.size(); ++tag) total_hitcount[tag] += hitcount[tag];
+			}
+			std::cout << "iterations " << total << " per second " << (total - previous_total) / seconds << '\n';
+			for (uint64_t tag = 0; tag < total_hitcount.size(); ++tag)
+				std::cout << "tag " << tag << ' ' << total_hitcount[tag] << '\n';
+			previous_total = total;
+			previous_time = current_time;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	}
+
+	for (uint64_t x = 0; x < mmap_list.size(); ++x)
+	{
+		if (munmap(mmap_list[x], mmap_size) == -1) error("munmap failure");
+		if (shm_unlink((std::string("/") + std::to_string(id_list[x])).c_str()) == -1) error("shm_unlink failure");
+	}
+	return 0;
+}
+
+int main(int argc, char* argv[]) {
+	if (argc == 3 && strcmp(argv[1], "farm") == 0) return run_farm(std::stoull(argv[2]));
 
 	std::random_device random;
 